@@ -0,0 +1,538 @@
+/******************************************************************************
+
+   @file    batch.cpp
+   @author  Rajmund Szymanski
+   @date    29.12.2020
+   @brief   headless batch modes: find, test, sort, raise, optimize, isomorphs and make
+
+*******************************************************************************
+
+   Copyright (c) 2018 - 2020 Rajmund Szymanski. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+
+******************************************************************************/
+
+#include "batch.hpp"
+#include "gametimer.hpp"
+#include <csignal>
+#include <atomic>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+
+static const TCHAR *title = _T("Sudoku");
+
+static std::atomic<bool> interrupted{false};
+
+static void interrupt( int )
+{
+	interrupted = true;
+}
+
+void SudokuBatch::load( std::vector<string> &lst )
+{
+	for (string &f: SudokuBatch::files)
+		Sudoku::load(lst, f.c_str());
+	if (lst.size() == 0)
+		Sudoku::load(lst, SudokuBatch::file.c_str());
+}
+
+// signatures of the boards we already have on disk are skipped by every mode
+size_t SudokuBatch::preload( SudokuIndex &data )
+{
+	for (string &f: SudokuBatch::known)
+		data.load(f.c_str());
+	if (data.size() > 0)
+		std::cerr << ::title << ": " << data.size() << " signatures preloaded" << std::endl;
+	return data.size();
+}
+
+// boards found by the workers of the parallel find mode, tagged with the round (the number of the board
+// generated by the worker) and the worker number, and the index of the boards already written; both are
+// shared by the workers and the writer, which takes the boards in the order of rounds and workers
+class SudokuQueue
+{
+	static constexpr uint64_t ahead = 64; // rounds a worker can be ahead of the writer
+
+	using Tag = std::pair<uint64_t, unsigned>;
+
+	std::mutex                                                         mtx;
+	std::condition_variable                                            cnd;
+	std::map<Tag, std::pair<uint64_t, std::optional<Sudoku>>>          buf;
+	std::vector<uint64_t>                                              end; // rounds of the finished workers
+	SudokuIndex                                                       &data;
+	unsigned                                                           run; // workers still running
+	Tag                                                                next{0, 0};
+
+public:
+
+	SudokuQueue( SudokuIndex &_d, unsigned _n ): end(_n, UINT64_MAX), data{_d}, run{_n} {}
+
+	// the workers skip the boards already written before testing them
+	bool contains( uint64_t key )
+	{
+		std::lock_guard<std::mutex> lock(SudokuQueue::mtx);
+		return SudokuQueue::data.contains(key);
+	}
+
+	// false if the key was already there
+	bool insert( uint64_t key )
+	{
+		std::lock_guard<std::mutex> lock(SudokuQueue::mtx);
+		return SudokuQueue::data.insert(key);
+	}
+
+	// every round of the worker is pushed, the rejected board as an empty one
+	void push( unsigned worker, uint64_t round, uint64_t key, const Sudoku *sudoku )
+	{
+		std::unique_lock<std::mutex> lock(SudokuQueue::mtx);
+		SudokuQueue::cnd.wait(lock, [this, round]{ return round < SudokuQueue::next.first + ahead || ::interrupted; });
+		auto &slot = SudokuQueue::buf[Tag{round, worker}];
+		slot.first = key;
+		if (sudoku != nullptr)
+			slot.second = *sudoku;
+		SudokuQueue::cnd.notify_all();
+	}
+
+	void finish( unsigned worker, uint64_t rounds )
+	{
+		std::lock_guard<std::mutex> lock(SudokuQueue::mtx);
+		SudokuQueue::end[worker] = rounds;
+		SudokuQueue::run--;
+		SudokuQueue::cnd.notify_all();
+	}
+
+	// false if all the workers have finished and all their boards have been taken
+	bool pop( uint64_t &key, Sudoku &sudoku )
+	{
+		std::unique_lock<std::mutex> lock(SudokuQueue::mtx);
+		for (;;)
+		{
+			if (SudokuQueue::next.second == SudokuQueue::end.size())
+			{
+				SudokuQueue::next = Tag{SudokuQueue::next.first + 1, 0};
+				SudokuQueue::cnd.notify_all();
+			}
+
+			auto i = SudokuQueue::buf.find(SudokuQueue::next);
+			if (i != SudokuQueue::buf.end())
+			{
+				bool found = i->second.second.has_value();
+				if (found)
+				{
+					key = i->second.first;
+					sudoku = *i->second.second;
+				}
+				SudokuQueue::buf.erase(i);
+				SudokuQueue::next.second++;
+				if (found)
+					return true;
+				continue;
+			}
+
+			if (SudokuQueue::next.first >= SudokuQueue::end[SudokuQueue::next.second])
+			{
+				if (SudokuQueue::run == 0 && SudokuQueue::buf.empty())
+					return false;
+				SudokuQueue::next.second++;
+				continue;
+			}
+
+			SudokuQueue::cnd.wait(lock);
+		}
+	}
+};
+
+// every worker owns its board and its random stream (the seed after as many jumps as the worker number);
+// the boards are written in the order of rounds and workers, so for a given seed and number of workers
+// the output is always the same (up to the moment of interruption); a slow worker holds up the writer,
+// the others can be up to 64 rounds ahead; the boards found before the interruption are written too
+int SudokuBatch::find( uint n )
+{
+	auto timer  = GameTimer<int>();
+	auto data   = SudokuIndex(SudokuBatch::dedup);
+	auto pool   = std::vector<std::thread>();
+
+	auto pre = SudokuBatch::preload(data);
+	auto queue = SudokuQueue(data, n);
+
+	std::cerr << ::title << " find: " << n << " workers, seed " << SudokuBatch::seed << std::endl;
+
+	interrupted = false;
+	auto handler = std::signal(SIGINT, interrupt);
+
+	for (uint i = 0; i < n; i++)
+	{
+		pool.emplace_back([this, i, &data, &queue]
+		{
+			auto sudoku = Sudoku(Difficulty::Medium);
+			sudoku.rnd.seed(SudokuBatch::seed);
+			for (uint k = 0; k < i; k++)
+				sudoku.rnd.jump();
+			sudoku.engine = SudokuBatch::engine;
+			sudoku.grader = SudokuBatch::grader;
+			sudoku.budget = SudokuBatch::budget;
+			sudoku.target = SudokuBatch::ext == _T('x') ? 0 : INT_MIN;
+
+			uint64_t round = 0;
+			while (!interrupted)
+			{
+				sudoku.generate();
+				if (SudokuBatch::ext == _T('r') || SudokuBatch::ext == _T('x'))
+				{
+					if (SudokuBatch::clues > 0)
+						sudoku.reduce(SudokuBatch::clues, SudokuBatch::limit * 1000);
+					sudoku.raise(SudokuBatch::ext == _T('x'), false);
+				}
+				uint64_t key = data.key(sudoku);
+				bool found = !queue.contains(key) && sudoku.test(SudokuBatch::ext != _T('x'));
+				queue.push(i, round++, key, found ? &sudoku : nullptr);
+			}
+
+			queue.finish(i, round);
+		});
+	}
+
+	uint64_t key;
+	uint     cnt = 0;
+	auto sudoku = Sudoku(Difficulty::Medium);
+	while (queue.pop(key, sudoku))
+	{
+		if (SudokuBatch::count > 0 && cnt >= SudokuBatch::count)
+			continue;
+		if (queue.insert(key))
+		{
+			std::cout << sudoku << std::endl;
+			sudoku.append(SudokuBatch::file.c_str());
+			if (SudokuBatch::count > 0 && ++cnt >= SudokuBatch::count)
+				interrupted = true;
+		}
+	}
+
+	for (auto &t: pool)
+		t.join();
+	std::signal(SIGINT, handler);
+
+	std::cerr << ::title << " find: " << data.size() - pre << " boards found, " << timer.now() << 's' << std::endl;
+	return 0;
+}
+
+int SudokuBatch::find()
+{
+	if (SudokuBatch::files.size() > 0)
+		SudokuBatch::file = SudokuBatch::files.front();
+
+	if (SudokuBatch::jobs > 1)
+		return SudokuBatch::find(SudokuBatch::jobs);
+
+	auto sudoku = Sudoku(Difficulty::Medium);
+	sudoku.rnd.seed(SudokuBatch::seed);
+	sudoku.engine = SudokuBatch::engine;
+	sudoku.grader = SudokuBatch::grader;
+	sudoku.budget = SudokuBatch::budget;
+	sudoku.target = SudokuBatch::ext == _T('x') ? 0 : INT_MIN;
+	auto timer  = GameTimer<int>();
+	auto data   = SudokuIndex(SudokuBatch::dedup);
+
+	auto pre = SudokuBatch::preload(data);
+
+	std::cerr << ::title << " find: seed " << SudokuBatch::seed << std::endl;
+
+	interrupted = false;
+	auto handler = std::signal(SIGINT, interrupt);
+	while (!interrupted)
+	{
+		sudoku.generate();
+		if (SudokuBatch::ext == _T('r') || SudokuBatch::ext == _T('x'))
+		{
+			if (SudokuBatch::clues > 0)
+				sudoku.reduce(SudokuBatch::clues, SudokuBatch::limit * 1000);
+			sudoku.raise(SudokuBatch::ext == _T('x'));
+		}
+		if (uint64_t key = data.key(sudoku); !data.contains(key) && sudoku.test(SudokuBatch::ext != _T('x')))
+		{
+			data.insert(key);
+			std::cout << sudoku << std::endl;
+			sudoku.append(SudokuBatch::file.c_str());
+			if (SudokuBatch::count > 0 && data.size() - pre >= SudokuBatch::count)
+				interrupted = true;
+		}
+	}
+	std::signal(SIGINT, handler);
+
+	std::cerr << ::title << " find: " << data.size() - pre << " boards found, " << timer.now() << 's' << std::endl;
+	return 0;
+}
+
+int SudokuBatch::test()
+{
+	int  cnt    = 0;
+	auto sudoku = Sudoku(Difficulty::Medium);
+	sudoku.engine = SudokuBatch::engine;
+	sudoku.grader = SudokuBatch::grader;
+	sudoku.jobs   = SudokuBatch::jobs;
+	sudoku.budget = SudokuBatch::budget;
+	sudoku.target = 0;
+	auto timer  = GameTimer<int>();
+	auto data   = SudokuIndex(SudokuBatch::dedup);
+	auto coll   = std::vector<Sudoku>();
+	auto lst    = std::vector<string>();
+
+	SudokuBatch::load(lst);
+
+	auto pre = SudokuBatch::preload(data);
+
+	std::cerr << ::title << " test: " << lst.size() << " boards loaded" << std::endl;
+
+	for (string &i: lst)
+	{
+		std::cerr << ' ' << ++cnt << '\r';
+		sudoku.init(i);
+		if (uint64_t key = data.key(sudoku); !data.contains(key) && sudoku.test(false))
+		{
+			data.insert(key);
+			coll.emplace_back(sudoku);
+		}
+	}
+
+	std::sort(coll.begin(), coll.end(), SudokuBatch::ext == _T('w') ? Sudoku::by_weight : SudokuBatch::ext == _T('l') ? Sudoku::by_length : Sudoku::by_rating);
+
+	for (auto &tab: coll)
+		std::cout << tab << std::endl;
+
+	std::cerr << ::title << " test: " << data.size() - pre << " boards found, " << timer.now() << 's' << std::endl;
+	std::cerr << ::title << " test: rating memo " << Sudoku::memo().hits << " hits, " << Sudoku::memo().misses << " misses" << std::endl;
+	return 0;
+}
+
+int SudokuBatch::sort()
+{
+	int  cnt    = 0;
+	auto sudoku = Sudoku(Difficulty::Medium);
+	sudoku.engine = SudokuBatch::engine;
+	sudoku.grader = SudokuBatch::grader;
+	sudoku.jobs   = SudokuBatch::jobs;
+	sudoku.budget = SudokuBatch::budget;
+	auto timer  = GameTimer<int>();
+	auto data   = SudokuIndex(SudokuBatch::dedup);
+	auto coll   = std::vector<Sudoku>();
+	auto lst    = std::vector<string>();
+
+	SudokuBatch::load(lst);
+
+	auto pre = SudokuBatch::preload(data);
+
+	std::cerr << ::title << " sort: " << lst.size() << " boards loaded" << std::endl;
+
+	for (string &i: lst)
+	{
+		std::cerr << ' ' << ++cnt << '\r';
+		sudoku.init(i);
+		if (uint64_t key = data.key(sudoku); !data.contains(key) && sudoku.test(true))
+		{
+			data.insert(key);
+			coll.emplace_back(sudoku);
+		}
+	}
+
+	std::sort(coll.begin(), coll.end(), SudokuBatch::ext == _T('w') ? Sudoku::by_weight : SudokuBatch::ext == _T('l') ? Sudoku::by_length : Sudoku::by_rating);
+
+	for (auto &tab: coll)
+		std::cout << tab << std::endl;
+
+	std::cerr << ::title << " sort: " << data.size() - pre << " boards found, " << timer.now() << 's' << std::endl;
+	std::cerr << ::title << " sort: rating memo " << Sudoku::memo().hits << " hits, " << Sudoku::memo().misses << " misses" << std::endl;
+	return 0;
+}
+
+int SudokuBatch::raise()
+{
+	int  cnt    = 0;
+	auto sudoku = Sudoku(Difficulty::Medium);
+	sudoku.rnd.seed(SudokuBatch::seed);
+	sudoku.engine = SudokuBatch::engine;
+	sudoku.grader = SudokuBatch::grader;
+	sudoku.jobs   = SudokuBatch::jobs;
+	sudoku.budget = SudokuBatch::budget;
+	sudoku.target = SudokuBatch::ext == _T('x') ? 0 : INT_MIN;
+	auto timer  = GameTimer<int>();
+	auto data   = SudokuIndex(SudokuBatch::dedup);
+	auto lst    = std::vector<string>();
+
+	SudokuBatch::load(lst);
+
+	auto pre = SudokuBatch::preload(data);
+
+	std::cerr << ::title << " raise: " << lst.size() << " boards loaded, seed " << SudokuBatch::seed << std::endl;
+
+	for (string &i: lst)
+	{
+		std::cerr << ' ' << ++cnt << '\r';
+		sudoku.init(i);
+		if (SudokuBatch::clues > 0)
+			sudoku.reduce(SudokuBatch::clues, SudokuBatch::limit * 1000);
+		sudoku.raise(SudokuBatch::ext == _T('x'));
+		if (uint64_t key = data.key(sudoku); !data.contains(key) && sudoku.test(SudokuBatch::ext != _T('x')))
+		{
+			data.insert(key);
+			std::cout << sudoku << std::endl;
+		}
+	}
+
+	std::cerr << ::title << " raise: " << data.size() - pre << " boards found, " << timer.now() << 's' << std::endl;
+	std::cerr << ::title << " raise: rating memo " << Sudoku::memo().hits << " hits, " << Sudoku::memo().misses << " misses" << std::endl;
+	return 0;
+}
+
+// every run starts from a new board and anneals it for the time limit;
+// the runs that reach the target weight with an Expert layout are stored
+int SudokuBatch::optimize()
+{
+	if (SudokuBatch::files.size() > 0)
+		SudokuBatch::file = SudokuBatch::files.front();
+
+	auto sudoku = Sudoku(Difficulty::Medium);
+	sudoku.rnd.seed(SudokuBatch::seed);
+	sudoku.engine = SudokuBatch::engine;
+	sudoku.grader = SudokuBatch::grader;
+	sudoku.jobs   = SudokuBatch::jobs;
+	sudoku.budget = SudokuBatch::budget;
+	auto timer  = GameTimer<int>();
+	auto data   = SudokuIndex(SudokuBatch::dedup);
+	auto stats  = Sudoku::Stats();
+
+	auto pre = SudokuBatch::preload(data);
+
+	std::cerr << ::title << " optimize: target weight " << SudokuBatch::weight << ", " << SudokuBatch::limit << "s per run, seed " << SudokuBatch::seed << std::endl;
+
+	interrupted = false;
+	auto handler = std::signal(SIGINT, interrupt);
+	while (!interrupted)
+	{
+		sudoku.generate(Difficulty::Medium);
+		if (sudoku.anneal(SudokuBatch::weight, SudokuBatch::limit * 1000, stats))
+		{
+			if (uint64_t key = data.key(sudoku); !data.contains(key))
+			{
+				data.insert(key);
+				std::cout << sudoku << std::endl;
+				sudoku.append(SudokuBatch::file.c_str());
+			}
+		}
+		int sec = std::max(timer.now(), 1);
+		std::cerr << ' ' << stats.runs << " runs, " << stats.found << " found, "
+		          << stats.accepted << '/' << stats.moves << " moves accepted, best weight " << stats.best << ", "
+		          << (data.size() - pre) * 3600 / static_cast<size_t>(sec) << " boards/h\r";
+	}
+	std::signal(SIGINT, handler);
+
+	std::cerr << std::endl;
+	std::cerr << ::title << " optimize: " << data.size() - pre << " boards found, " << timer.now() << 's' << std::endl;
+	return 0;
+}
+
+// every board read (or every built-in extreme board) gives the given number of its isomorphs
+int SudokuBatch::isomorphs()
+{
+	auto sudoku = Sudoku(Difficulty::Medium);
+	sudoku.rnd.seed(SudokuBatch::seed);
+	sudoku.engine = SudokuBatch::engine;
+	sudoku.grader = SudokuBatch::grader;
+	auto timer  = GameTimer<int>();
+	auto lst    = std::vector<string>();
+	size_t cnt  = 0;
+
+	if (SudokuBatch::ext == _T('x'))
+		lst = Sudoku::extremes();
+	else
+		SudokuBatch::load(lst);
+
+	std::cerr << ::title << " isomorphs: " << lst.size() << " boards loaded, seed " << SudokuBatch::seed << std::endl;
+
+	for (string &i: lst)
+	{
+		sudoku.init(i);
+		for (auto &tab: sudoku.isomorphs(SudokuBatch::count > 0 ? SudokuBatch::count : 10))
+		{
+			std::cout << tab << std::endl;
+			cnt++;
+		}
+	}
+
+	std::cerr << ::title << " isomorphs: " << cnt << " boards made, " << timer.now() << 's' << std::endl;
+	return 0;
+}
+
+// the boards read are rated and written to the pool file; the boards passing
+// the test for extreme are stored at the Extreme level, the other ones at their own
+int SudokuBatch::make()
+{
+	int  cnt    = 0;
+	auto sudoku = Sudoku(Difficulty::Medium);
+	sudoku.engine = SudokuBatch::engine;
+	sudoku.grader = SudokuBatch::grader;
+	sudoku.jobs   = SudokuBatch::jobs;
+	auto timer  = GameTimer<int>();
+	auto data   = SudokuIndex(SudokuBatch::dedup);
+	auto recs   = std::vector<SudokuPool::Record>();
+	auto lst    = std::vector<string>();
+	size_t top  = 0;
+
+	SudokuBatch::load(lst);
+
+	auto pre = SudokuBatch::preload(data);
+
+	std::cerr << ::title << " make: " << lst.size() << " boards loaded" << std::endl;
+
+	for (string &i: lst)
+	{
+		std::cerr << ' ' << ++cnt << '\r';
+		sudoku.init(i);
+		if (uint64_t key = data.key(sudoku); !data.contains(key) && sudoku.test(true))
+		{
+			data.insert(key);
+			auto rec = sudoku.record();
+			if (sudoku.test(false))
+			{
+				rec.level = Difficulty::Extreme;
+				top++;
+			}
+			recs.push_back(rec);
+		}
+	}
+
+	if (!SudokuPool::write(SudokuBatch::store.c_str(), recs))
+	{
+		std::cerr << "Sudoku: cannot write " << SudokuBatch::store << std::endl;
+		return 1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	auto check = SudokuPool(SudokuBatch::store.c_str());
+	auto usec  = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+	std::cerr << ::title << " make: " << data.size() - pre << " boards written (" << top << " extreme), " << timer.now() << 's' << std::endl;
+	std::cerr << ::title << " make: " << check.size() << " boards mapped in " << usec << "us" << std::endl;
+	return check.size() == recs.size() ? 0 : 1;
+}
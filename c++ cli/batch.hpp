@@ -0,0 +1,73 @@
+/******************************************************************************
+
+   @file    batch.hpp
+   @author  Rajmund Szymanski
+   @date    29.12.2020
+   @brief   headless batch modes: find, test, sort, raise, optimize, isomorphs and make
+
+*******************************************************************************
+
+   Copyright (c) 2018 - 2020 Rajmund Szymanski. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+
+******************************************************************************/
+
+#pragma once
+
+#include "sudoku.hpp"
+#include <string>
+#include <vector>
+
+class SudokuBatch
+{
+	using string = std::basic_string<TCHAR>;
+
+	void load( std::vector<string> & );
+	size_t preload( SudokuIndex & );
+	int  find( uint );
+
+public:
+
+	TCHAR    ext;
+	Engine   engine;
+	Grader   grader;
+	uint     jobs;
+	Sudoku::Budget budget;
+	int      weight;  // target weight of the optimizer
+	uint     limit;   // seconds per run of the optimizer and per board of the low-clue search
+	uint     clues;   // clues of the low-clue search (0: none)
+	uint     count;   // isomorphs of every board (0: ten), boards of the find mode (0: no limit)
+	Dedup    dedup;
+	uint64_t seed;    // seed of the random streams (worker i: the stream after i jumps)
+	string   file;
+	string   store;   // pool file written by the make mode (and read by the other modes)
+	std::vector<string> files;
+	std::vector<string> known;
+
+	SudokuBatch( const TCHAR *_f ): ext{0}, engine{Engine::Backtracking}, grader{Grader::Search}, jobs{1}, budget{}, weight{0}, limit{10}, clues{0}, count{0}, dedup{Dedup::Signature}, seed{static_cast<uint64_t>(std::random_device{}()) << 32 | std::random_device{}()}, file{_f}, store{_T("sudoku.pool")}, files{}, known{} {}
+
+	int find();
+	int test();
+	int sort();
+	int raise();
+	int optimize();
+	int isomorphs();
+	int make();
+};
@@ -0,0 +1,307 @@
+/******************************************************************************
+
+   @file    hitting.hpp
+   @author  Rajmund Szymanski
+   @date    29.12.2020
+   @brief   low-clue layouts of a solution grid (hitting of the unavoidable sets)
+
+*******************************************************************************
+
+   Copyright (c) 2018 - 2020 Rajmund Szymanski. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+
+******************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <chrono>
+#include <cstdint>
+#include <bit>
+
+// An unavoidable set of a solution grid is a set of cells whose digits can be
+// rearranged into another solution; every layout with the unique solution has
+// a clue in each of them. The sets are found by clearing the cells of two or
+// three digits and listing the other solutions, and are kept minimal (no set
+// contains another one). The search picks clues only from an unhit set, never
+// goes back to a cell already tried at a lower level of the tree and stops a
+// branch when the disjoint unhit sets need more clues than are left; only the
+// layouts hitting every set are checked for uniqueness, and a failed check
+// adds the set found by the solver.
+
+class SudokuHitting
+{
+	using uint = unsigned int;
+
+public:
+
+	using Grid = std::array<uint8_t, 81>;
+
+private:
+
+	struct Mask
+	{
+		uint64_t lo{0}; // cells 0..63
+		uint64_t hi{0}; // cells 64..80
+
+		void set ( uint p )       { if (p < 64) lo |= 1ULL << p; else hi |= 1ULL << (p - 64); }
+		bool test( uint p ) const { return p < 64 ? (lo >> p) & 1 : (hi >> (p - 64)) & 1; }
+		bool meets ( const Mask &m ) const { return (lo & m.lo) != 0 || (hi & m.hi) != 0; }
+		bool within( const Mask &m ) const { return (lo & ~m.lo) == 0 && (hi & ~m.hi) == 0; }
+		uint count() const { return static_cast<uint>(std::popcount(lo) + std::popcount(hi)); }
+
+		template<class F>
+		void for_each( F f ) const
+		{
+			for (uint64_t m = lo; m != 0; m &= m - 1) f(static_cast<uint>(std::countr_zero(m)));
+			for (uint64_t m = hi; m != 0; m &= m - 1) f(static_cast<uint>(std::countr_zero(m)) + 64);
+		}
+	};
+
+	// plain solver of a partial grid: the solutions are handed to the callback until it returns false
+	struct Solver
+	{
+		Grid     g;
+		uint16_t row[9], col[9], box[9];
+
+		static uint boxof( uint p ) { return p / 27 * 3 + p % 9 / 3; }
+
+		bool init( const Grid &grid )
+		{
+			Solver::g = grid;
+			std::fill(Solver::row, Solver::row + 9, 0);
+			std::fill(Solver::col, Solver::col + 9, 0);
+			std::fill(Solver::box, Solver::box + 9, 0);
+			for (uint p = 0; p < 81; p++)
+			{
+				if (Solver::g[p] == 0)
+					continue;
+				uint16_t b = static_cast<uint16_t>(1U << Solver::g[p]);
+				if ((Solver::row[p / 9] | Solver::col[p % 9] | Solver::box[boxof(p)]) & b)
+					return false;
+				Solver::row[p / 9] |= b; Solver::col[p % 9] |= b; Solver::box[boxof(p)] |= b;
+			}
+			return true;
+		}
+
+		template<class F>
+		bool run( F &f )
+		{
+			uint best = 81, len = 10;
+			uint16_t cand = 0;
+			for (uint p = 0; p < 81; p++)
+			{
+				if (Solver::g[p] != 0)
+					continue;
+				uint16_t m = static_cast<uint16_t>(~(Solver::row[p / 9] | Solver::col[p % 9] | Solver::box[boxof(p)]) & 0x3FE);
+				uint n = static_cast<uint>(std::popcount(m));
+				if (n < len)
+				{
+					best = p; len = n; cand = m;
+					if (n <= 1)
+						break;
+				}
+			}
+
+			if (best == 81)
+				return f(Solver::g);
+
+			for (; cand != 0; cand &= static_cast<uint16_t>(cand - 1))
+			{
+				uint v = static_cast<uint>(std::countr_zero(cand));
+				uint16_t b = static_cast<uint16_t>(1U << v);
+				Solver::g[best] = static_cast<uint8_t>(v);
+				Solver::row[best / 9] |= b; Solver::col[best % 9] |= b; Solver::box[boxof(best)] |= b;
+				bool more = Solver::run(f);
+				Solver::row[best / 9] ^= b; Solver::col[best % 9] ^= b; Solver::box[boxof(best)] ^= b;
+				Solver::g[best] = 0;
+				if (!more)
+					return false;
+			}
+
+			return true;
+		}
+	};
+
+	using clock = std::chrono::steady_clock;
+
+	Grid               sol;
+	std::vector<Mask>  sets;    // unavoidable sets, minimal, the smallest first
+	std::array<uint, 81> rank;  // order of the cells tried within a set
+	clock::time_point  deadline;
+	uint64_t           nodes;
+	bool               out;
+	Grid               found;
+
+	// the set is kept if no other set is within it; the sets containing it are dropped
+	void add( const Mask &m )
+	{
+		for (const Mask &s: SudokuHitting::sets)
+			if (s.within(m))
+				return;
+
+		SudokuHitting::sets.erase(std::remove_if(SudokuHitting::sets.begin(), SudokuHitting::sets.end(),
+		                          [&m]( const Mask &s ){ return m.within(s); }), SudokuHitting::sets.end());
+		auto pos = std::find_if(SudokuHitting::sets.begin(), SudokuHitting::sets.end(), [&m]( const Mask &s ){ return s.count() > m.count(); });
+		SudokuHitting::sets.insert(pos, m);
+	}
+
+	Mask diff( const Grid &g ) const
+	{
+		Mask m{};
+		for (uint p = 0; p < 81; p++)
+			if (g[p] != SudokuHitting::sol[p])
+				m.set(p);
+		return m;
+	}
+
+	// the sets hidden by the cells of the given digits (at most limit other solutions are listed)
+	void digits( uint mask, uint limit )
+	{
+		Grid g = SudokuHitting::sol;
+		for (uint8_t &v: g)
+			if ((mask >> v) & 1)
+				v = 0;
+
+		Solver s;
+		s.init(g);
+		auto f = [this, &limit]( const Grid &x ){ Mask m = SudokuHitting::diff(x); if (m.count() > 0) SudokuHitting::add(m); return --limit > 0; };
+		s.run(f);
+	}
+
+	// the solution is unique: nothing more to do; otherwise the difference is a new unavoidable set
+	bool unique( const Mask &clues )
+	{
+		Grid g{};
+		clues.for_each([&]( uint p ){ g[p] = SudokuHitting::sol[p]; });
+
+		Solver s;
+		s.init(g);
+		Mask m{};
+		auto f = [this, &m]( const Grid &x ){ m = SudokuHitting::diff(x); return m.count() == 0; };
+		s.run(f);
+		if (m.count() == 0)
+			return true;
+		SudokuHitting::add(m);
+		return false;
+	}
+
+	bool spend()
+	{
+		if ((++SudokuHitting::nodes & 0xFF) == 0 && clock::now() >= SudokuHitting::deadline)
+			SudokuHitting::out = true;
+		return !SudokuHitting::out;
+	}
+
+	// clues: cells taken, dead: cells excluded in this branch, left: clues that can still be added
+	bool search( Mask clues, Mask dead, uint left )
+	{
+		for (;;)
+		{
+			if (!SudokuHitting::spend())
+				return false;
+
+			// the smallest unhit set (counting the cells still allowed) and the disjoint ones
+			const Mask *pick = nullptr;
+			uint size = 82, need = 0;
+			Mask used{};
+			for (const Mask &s: SudokuHitting::sets)
+			{
+				if (s.meets(clues))
+					continue;
+				Mask a{ s.lo & ~dead.lo, s.hi & ~dead.hi };
+				uint n = a.count();
+				if (n == 0)
+					return false;
+				if (n < size)
+					pick = &s, size = n;
+				if (!s.meets(used))
+				{
+					used.lo |= s.lo; used.hi |= s.hi;
+					if (++need > left)
+						return false;
+				}
+			}
+
+			if (pick == nullptr)
+			{
+				if (!SudokuHitting::unique(clues))
+					continue;
+				for (uint p = 0; p < 81; p++)
+					SudokuHitting::found[p] = clues.test(p) ? SudokuHitting::sol[p] : 0;
+				return true;
+			}
+
+			auto cells = std::vector<uint>();
+			pick->for_each([&]( uint p ){ if (!dead.test(p)) cells.push_back(p); });
+			std::sort(cells.begin(), cells.end(), [this]( uint a, uint b ){ return SudokuHitting::rank[a] < SudokuHitting::rank[b]; });
+
+			for (uint p: cells)
+			{
+				Mask c = clues;
+				c.set(p);
+				if (SudokuHitting::search(c, dead, left - 1))
+					return true;
+				if (SudokuHitting::out)
+					return false;
+				dead.set(p);
+			}
+			return false;
+		}
+	}
+
+public:
+
+	explicit SudokuHitting( const Grid &grid ): sol{grid}, sets{}, rank{}, deadline{}, nodes{0}, out{false}, found{}
+	{
+		for (uint a = 1; a <= 9; a++)
+			for (uint b = a + 1; b <= 9; b++)
+				SudokuHitting::digits((1U << a) | (1U << b), 64);
+
+		for (uint a = 1; a <= 9; a++)
+			for (uint b = a + 1; b <= 9; b++)
+				for (uint c = b + 1; c <= 9; c++)
+					SudokuHitting::digits((1U << a) | (1U << b) | (1U << c), 256);
+	}
+
+	size_t size() const { return SudokuHitting::sets.size(); }
+
+	// a layout of at most n clues with the unique solution of the grid, searched for ms milliseconds;
+	// the seed sets the order of the cells, so different seeds search different parts of the tree
+	bool search( uint n, uint ms, uint32_t seed, Grid &layout )
+	{
+		std::iota(SudokuHitting::rank.begin(), SudokuHitting::rank.end(), 0U);
+		std::shuffle(SudokuHitting::rank.begin(), SudokuHitting::rank.end(), std::mt19937{seed});
+
+		SudokuHitting::deadline = clock::now() + std::chrono::milliseconds(ms);
+		SudokuHitting::nodes = 0;
+		SudokuHitting::out = false;
+
+		if (!SudokuHitting::search(Mask{}, Mask{}, n))
+			return false;
+
+		layout = SudokuHitting::found;
+		return true;
+	}
+};
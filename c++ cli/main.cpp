@@ -0,0 +1,250 @@
+/******************************************************************************
+
+   @file    main.cpp
+   @author  Rajmund Szymanski
+   @date    29.12.2020
+   @brief   Sudoku solver and generator, command line tool
+
+*******************************************************************************
+
+   Copyright (c) 2018 - 2020 Rajmund Szymanski. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+
+******************************************************************************/
+
+#include "batch.hpp"
+#include <iostream>
+#include <thread>
+#include <cctype>
+
+int main( int argc, char **argv )
+{
+	TCHAR cmd = _T('h');
+	auto  tmp = std::basic_string<TCHAR>(*argv) + _T(".board");
+	auto  app = SudokuBatch(tmp.c_str());
+
+	if (--argc > 0 && (++argv, **argv == _T('/') || **argv == _T('-')))
+	{
+		cmd = (TCHAR)std::tolower(*++*argv);
+		if (cmd != 0)
+			app.ext = (TCHAR)std::tolower(*++*argv);
+	}
+
+	while (--argc > 0)
+	{
+		auto arg = std::basic_string<TCHAR>(*++argv);
+		if (arg == _T("-e") && argc > 1)
+		{
+			--argc;
+			arg = *++argv;
+			if (arg == _T("dlx"))
+				app.engine = Engine::DLX;
+			else
+			if (arg == _T("cp"))
+				app.engine = Engine::Propagation;
+			else
+			if (arg == _T("it"))
+				app.engine = Engine::Iterative;
+			else
+			if (arg == _T("bt"))
+				app.engine = Engine::Backtracking;
+			else
+			{
+				std::cerr << "Sudoku: unknown engine" << std::endl;
+				return 1;
+			}
+		}
+		else
+		if (arg == _T("-b") && argc > 1)
+		{
+			--argc;
+			app.budget.nodes = std::stoull(*++argv);
+		}
+		else
+		if (arg == _T("-bt") && argc > 1)
+		{
+			--argc;
+			app.budget.ms = static_cast<uint>(std::stoul(*++argv));
+		}
+		else
+		if (arg == _T("-g") && argc > 1)
+		{
+			--argc;
+			arg = *++argv;
+			if (arg == _T("search"))
+				app.grader = Grader::Search;
+			else
+			if (arg == _T("logic"))
+				app.grader = Grader::Logic;
+			else
+			{
+				std::cerr << "Sudoku: unknown grader" << std::endl;
+				return 1;
+			}
+		}
+		else
+		if (arg == _T("-j") && argc > 1)
+		{
+			--argc;
+			app.jobs = static_cast<uint>(std::stoul(*++argv));
+			if (app.jobs == 0)
+				app.jobs = std::max(std::thread::hardware_concurrency(), 1U);
+		}
+		else
+		if (arg == _T("-k") && argc > 1)
+		{
+			--argc;
+			arg = *++argv;
+			if (arg == _T("sig"))
+				app.dedup = Dedup::Signature;
+			else
+			if (arg == _T("wide"))
+				app.dedup = Dedup::Digest;
+			else
+			if (arg == _T("min"))
+				app.dedup = Dedup::Canonical;
+			else
+			{
+				std::cerr << "Sudoku: unknown key" << std::endl;
+				return 1;
+			}
+		}
+		else
+		if (arg == _T("-c") && argc > 1)
+		{
+			--argc;
+			app.clues = static_cast<uint>(std::stoul(*++argv));
+		}
+		else
+		if (arg == _T("-n") && argc > 1)
+		{
+			--argc;
+			app.count = static_cast<uint>(std::stoul(*++argv));
+		}
+		else
+		if (arg == _T("-l") && argc > 1)
+		{
+			--argc;
+			app.limit = static_cast<uint>(std::stoul(*++argv));
+		}
+		else
+		if (arg == _T("-w") && argc > 1)
+		{
+			--argc;
+			app.weight = std::stoi(*++argv);
+		}
+		else
+		if (arg == _T("--pool") && argc > 1)
+		{
+			--argc;
+			app.store = *++argv;
+			Sudoku::pool_file = app.store;
+		}
+		else
+		if (arg == _T("--crc32c"))
+		{
+			Sudoku::castagnoli = true;
+		}
+		else
+		if (arg == _T("--seed") && argc > 1)
+		{
+			--argc;
+			app.seed = std::stoull(*++argv);
+		}
+		else
+		if (arg == _T("-p") && argc > 1)
+		{
+			--argc;
+			app.known.push_back(*++argv);
+		}
+		else
+			app.files.push_back(arg);
+	}
+
+	switch (cmd)
+	{
+		case _T('f'): return app.find();  // find
+		case _T('t'): return app.test();  // test
+		case _T('s'): return app.sort();  // sort
+		case _T('r'): return app.raise(); // raise
+		case _T('o'): return app.optimize(); // optimize
+		case _T('i'): return app.isomorphs(); // isomorphs
+		case _T('m'): return app.make();  // make pool
+
+		case _T('?'): /* falls through */
+		case _T('h'): // help
+		{
+			std::cerr << "\n"
+			             "Sudoku solver and generator\n"
+			             "\n"
+			             "Copyright (c) 2018 - 2020 Rajmund Szymanski. All rights reserved.\n"
+			             "This software is distributed under the MIT License.\n"
+			             "You are free to modify and redistribute it.\n"
+			             "\n"
+			             "Usage:\n"
+			             "sudoku-cli -f [file] - find (append to file, stop with Ctrl+C)\n"
+			             "           -fr       - force raise\n"
+			             "           -fx       - force raise and show extreme only\n"
+			             "sudoku-cli -t [file] - test for extreme (read from file)\n"
+			             "           -tw       - sort by weight/length (default is rating/length)\n"
+			             "           -tl       - sort by length/rating (default is rating/length)\n"
+			             "sudoku-cli -s [file] - sort (read from file)\n"
+			             "           -sw       - sort by weight/length (default is rating/length)\n"
+			             "           -sl       - sort by length/rating (default is rating/length)\n"
+			             "sudoku-cli -r [file] - raise (read from file)\n"
+			             "           -rx       - show extreme only\n"
+			             "sudoku-cli -i [file] - isomorphs of every board (read from file)\n"
+			             "           -ix       - isomorphs of the built-in extreme boards\n"
+			             "sudoku-cli -m [file] - make the pool of boards (read from file)\n"
+			             "sudoku-cli -o [file] - optimize by annealing (append to file, stop with Ctrl+C)\n"
+			             "options:\n"
+			             "           -e bt     - backtracking solver engine (default)\n"
+			             "           -e dlx    - dancing links solver engine\n"
+			             "           -e cp     - constraint propagation solver engine\n"
+			             "           -e it     - iterative (resumable) constraint propagation solver engine\n"
+			             "           -b N      - rating budget: N layouts parsed, then the rating is a lower bound\n"
+			             "           -bt MS    - rating budget: MS milliseconds, then the rating is a lower bound\n"
+			             "           -g search - rating by the size of the search tree (default)\n"
+			             "           -g logic  - rating by the hardest technique needed (hundreds) and weighted steps\n"
+			             "           -j N      - N workers for find, N threads for rating and raise (0: one per hardware thread)\n"
+			             "           -k sig    - duplicates have the same signature (default)\n"
+			             "           -k wide   - duplicates have the same givens (64-bit wide signature, isomorphs are kept)\n"
+			             "           -k min    - duplicates are isomorphic (minlex canonical form)\n"
+			             "           -w W      - target weight of the optimizer (default 0)\n"
+			             "           -l S      - S seconds per run of the optimizer and per board of the low-clue search (default 10)\n"
+			             "           -c N      - raise starts from a layout of at most N clues of the same solution, if found\n"
+			             "           -n K      - K isomorphs of every board (default 10), find stops after K boards (default: Ctrl+C)\n"
+			             "           --pool f  - pool file written by -m and read by the other modes (default sudoku.pool)\n"
+			             "           --crc32c  - signatures by CRC-32C (SSE4.2 if the CPU has it), not valid for the board files of CRC-32 (default)\n"
+			             "           --seed N  - seed of the random streams (default: random, shown at the start)\n"
+			             "           -p file   - skip the boards already stored in file (can be repeated)\n"
+			             "sudoku-cli -h        - this usage help\n"
+			             "sudoku-cli -?        - this usage help\n"
+			          << std::endl;
+			return 0;
+		}
+
+		default:
+		{
+			std::cerr << "Sudoku: unknown command" << std::endl;
+			return 1;
+		}
+	}
+}
@@ -0,0 +1,2999 @@
+/******************************************************************************
+
+   @file    sudoku.hpp
+   @author  Rajmund Szymanski
+   @date    29.12.2020
+   @brief   sudoku class: generator and solver
+
+*******************************************************************************
+
+   Copyright (c) 2018 - 2020 Rajmund Szymanski. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+
+******************************************************************************/
+
+#pragma once
+
+#include <list>
+#include <set>
+#include <array>
+#include <vector>
+#include <tuple>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <numeric>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <random>
+#include <cmath>
+#include <climits>
+#include <cstdint>
+#include <bit>
+#include <ranges>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+#include "dlx.hpp"
+#include "minlex.hpp"
+#include "hash.hpp"
+#include "logic.hpp"
+#include "hitting.hpp"
+#include "workers.hpp"
+#include "pool.hpp"
+
+#if defined(_WIN32)
+#include <tchar.h>
+#else
+using TCHAR = char;
+#define _T(x) x
+#endif
+
+class SudokuCell;
+class SudokuBoard;
+class Sudoku;
+
+using cell_ref = std::reference_wrapper<SudokuCell>;
+using cell_array = std::array<SudokuCell, 81>;
+using uint = unsigned int;
+
+// xoshiro256** generator seeded with splitmix64; jump() advances the stream by 2^128 draws,
+// so the streams of one seed taken after 0, 1, 2... jumps never overlap
+class SudokuRandom
+{
+	uint64_t s[4];
+
+	static uint64_t rotl( uint64_t x, int k ) { return (x << k) | (x >> (64 - k)); }
+
+public:
+
+	using result_type = uint64_t;
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return UINT64_MAX; }
+
+	explicit SudokuRandom( uint64_t x = static_cast<uint64_t>(std::random_device{}()) << 32 | std::random_device{}() ) { SudokuRandom::seed(x); }
+
+	void seed( uint64_t x )
+	{
+		for (uint64_t &v: SudokuRandom::s)
+		{
+			uint64_t z = (x += UINT64_C(0x9E3779B97F4A7C15));
+			z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+			z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+			v = z ^ (z >> 31);
+		}
+	}
+
+	result_type operator()()
+	{
+		uint64_t r = rotl(SudokuRandom::s[1] * 5, 7) * 9;
+		uint64_t t = SudokuRandom::s[1] << 17;
+		SudokuRandom::s[2] ^= SudokuRandom::s[0];
+		SudokuRandom::s[3] ^= SudokuRandom::s[1];
+		SudokuRandom::s[1] ^= SudokuRandom::s[2];
+		SudokuRandom::s[0] ^= SudokuRandom::s[3];
+		SudokuRandom::s[2] ^= t;
+		SudokuRandom::s[3] = rotl(SudokuRandom::s[3], 45);
+		return r;
+	}
+
+	void jump()
+	{
+		static constexpr uint64_t poly[4] = { 0x180EC6D33CFD0ABA, 0xD5A61266F0C9392C, 0xA9582618E03FC9AA, 0x39ABDC4529B1661C };
+		uint64_t t[4] = {};
+		for (uint64_t p: poly)
+			for (int b = 0; b < 64; b++)
+			{
+				if ((p >> b) & 1)
+					for (int i = 0; i < 4; i++)
+						t[i] ^= SudokuRandom::s[i];
+				(*this)();
+			}
+		std::copy(t, t + 4, SudokuRandom::s);
+	}
+
+	// unbiased value from 0 to n - 1 (multiply and reject)
+	uint below( uint n )
+	{
+		uint64_t m = ((*this)() >> 32) * n;
+		if (static_cast<uint32_t>(m) < n)
+		{
+			uint32_t t = static_cast<uint32_t>(-n) % n;
+			while (static_cast<uint32_t>(m) < t)
+				m = ((*this)() >> 32) * n;
+		}
+		return static_cast<uint>(m >> 32);
+	}
+
+	// value from [0, 1)
+	double real()
+	{
+		return static_cast<double>((*this)() >> 11) * 0x1.0p-53;
+	}
+};
+
+enum Difficulty
+{
+	Any = -1,
+	Easy = 0,
+	Medium,
+	Hard,
+	Expert,
+	Extreme,
+};
+
+enum class Force
+{
+	Direct,
+	Careful,
+	Safe,
+};
+
+enum class Engine
+{
+	Backtracking,
+	DLX,
+	Propagation,
+	Iterative,
+};
+
+enum class Grader
+{
+	Search,     // size of the search tree (parse_rating)
+	Logic,      // hardest technique needed and weighted steps (SudokuLogic)
+};
+
+enum class Dedup
+{
+	Signature,  // 32-bit signature, as stored in board files
+	Digest,     // 64-bit wide signature (the givens)
+	Canonical,  // minlex canonical form of the givens
+};
+
+class SudokuBits
+{
+	uint64_t lo{0}; // cells 0..63
+	uint64_t hi{0}; // cells 64..80
+
+	constexpr SudokuBits( uint64_t l, uint64_t h ): lo{l}, hi{h} {}
+
+public:
+
+	constexpr SudokuBits() = default;
+
+	constexpr void set  ( uint p ) { if (p < 64) lo |=  (1ULL << p); else hi |=  (1ULL << (p - 64)); }
+	constexpr void reset( uint p ) { if (p < 64) lo &= ~(1ULL << p); else hi &= ~(1ULL << (p - 64)); }
+
+	constexpr bool any() const { return (lo | hi) != 0; }
+
+	constexpr uint first() const { return lo != 0 ? static_cast<uint>(std::countr_zero(lo)) : hi != 0 ? static_cast<uint>(std::countr_zero(hi)) + 64 : 81; }
+
+	constexpr SudokuBits operator &( const SudokuBits &b ) const { return SudokuBits(lo & b.lo, hi & b.hi); }
+
+	template<class F>
+	void for_each( F f ) const
+	{
+		for (uint64_t m = lo; m != 0; m &= m - 1) f(static_cast<uint>(std::countr_zero(m)));
+		for (uint64_t m = hi; m != 0; m &= m - 1) f(static_cast<uint>(std::countr_zero(m)) + 64);
+	}
+
+	static constexpr
+	SudokuBits all() { return SudokuBits(~0ULL, (1ULL << (81 - 64)) - 1); }
+};
+
+class SudokuLinks
+{
+	using index = std::array<uint8_t, 3>;
+	using units = std::array<uint8_t, 8>;
+	using peers = std::array<uint8_t, 20>;
+	using cells = std::array<uint8_t, 9>;
+
+	template<class T, class F>
+	static constexpr
+	std::array<T, 81> make( F in )
+	{
+		std::array<T, 81> result{};
+		for (uint p = 0; p < 81; p++)
+		{
+			uint i = 0;
+			for (uint q = 0; q < 81; q++)
+				if (in(p, q))
+					result[p][i++] = static_cast<uint8_t>(q);
+		}
+		return result;
+	}
+
+	static constexpr
+	std::array<SudokuBits, 81> link()
+	{
+		std::array<SudokuBits, 81> result{};
+		for (uint p = 0; p < 81; p++)
+			for (uint q = 0; q < 81; q++)
+				if (in_lst(p, q))
+					result[p].set(q);
+		return result;
+	}
+
+	static constexpr
+	std::array<cells, 27> area()
+	{
+		std::array<cells, 27> result{};
+		std::array<uint, 27> size{};
+		for (uint p = 0; p < 81; p++)
+			for (uint u: make()[p])
+				result[u][size[u]++] = static_cast<uint8_t>(p);
+		return result;
+	}
+
+	static constexpr
+	std::array<index, 81> make()
+	{
+		std::array<index, 81> result{};
+		for (uint p = 0; p < 81; p++)
+			result[p] = { static_cast<uint8_t>(p / 9), static_cast<uint8_t>(p % 9 + 9), static_cast<uint8_t>((p / 27) * 3 + (p % 9) / 3 + 18) };
+		return result;
+	}
+
+public:
+
+	static constexpr bool in_row( uint p1, uint p2 ) { return p1 != p2 && p1 / 9 == p2 / 9; }
+	static constexpr bool in_col( uint p1, uint p2 ) { return p1 != p2 && p1 % 9 == p2 % 9; }
+	static constexpr bool in_seg( uint p1, uint p2 ) { return p1 != p2 && p1 / 27 == p2 / 27 && (p1 % 9) / 3 == (p2 % 9) / 3; }
+	static constexpr bool in_lst( uint p1, uint p2 ) { return in_row(p1, p2) || in_col(p1, p2) || in_seg(p1, p2); }
+
+	struct Table
+	{
+		std::array<index, 81> unit; // row, column and segment of the cell (units 0..26)
+		std::array<units, 81> row;
+		std::array<units, 81> col;
+		std::array<units, 81> seg;
+		std::array<peers, 81> lst;  // all linked cells, in ascending order
+		std::array<SudokuBits, 81> bits; // all linked cells, as a set
+		std::array<cells, 27> area; // cells of every unit
+	};
+
+	static const
+	Table table;
+};
+
+inline constexpr
+SudokuLinks::Table SudokuLinks::table =
+{
+	SudokuLinks::make(),
+	SudokuLinks::make<SudokuLinks::units>(SudokuLinks::in_row),
+	SudokuLinks::make<SudokuLinks::units>(SudokuLinks::in_col),
+	SudokuLinks::make<SudokuLinks::units>(SudokuLinks::in_seg),
+	SudokuLinks::make<SudokuLinks::peers>(SudokuLinks::in_lst),
+	SudokuLinks::link(),
+	SudokuLinks::area(),
+};
+
+class SudokuCell
+{
+	using Cell = SudokuCell;
+
+public:
+
+	uint pos{0};
+	uint num{0};
+	bool immutable{false};
+
+	class Values: public std::array<uint, 10>
+	{
+	public:
+
+		Values( Cell &cell, SudokuRandom *rnd = nullptr )
+		{
+			uint m = cell.mask();
+			for (uint v = 0; v < 10; v++)
+				Values::at(v) = (m & (1U << v)) ? v : 0;
+
+			if (rnd != nullptr)
+				std::shuffle(Values::begin(), Values::end(), *rnd);
+		}
+
+		uint len()
+		{
+			return std::count_if(Values::begin(), Values::end(), []( uint v ){ return v != 0; });
+		}
+	};
+
+private:
+
+	template<size_t N>
+	auto link( const std::array<uint8_t, N> &idx )
+	{
+		Cell * const tab = this - Cell::pos;
+		return std::views::transform(idx, [tab]( uint p ) -> Cell & { return tab[p]; });
+	}
+
+	auto row() { return Cell::link(SudokuLinks::table.row[Cell::pos]); }
+	auto col() { return Cell::link(SudokuLinks::table.col[Cell::pos]); }
+	auto seg() { return Cell::link(SudokuLinks::table.seg[Cell::pos]); }
+	auto lst() { return Cell::link(SudokuLinks::table.lst[Cell::pos]); }
+
+	inline SudokuBoard &tab();
+
+public:
+
+	bool linked( Cell *c )
+	{
+		if (c == nullptr)
+			return false;
+
+		return SudokuLinks::in_lst(Cell::pos, c->pos);
+	}
+
+	void init( uint p )
+	{
+		Cell::pos = p;
+	}
+
+	inline uint mask();           // available values (bit n for value n)
+	inline void put( uint n );    // the only way to change the digit
+	inline bool repeated();
+	inline uint len();            // number of available values (0 for a filled cell)
+	inline uint range();          // sum of the lengths of the linked cells
+
+	uint solid()
+	{
+		if (Cell::num == 0)
+			return 0;
+
+		return std::ranges::count_if(Cell::lst(), []( Cell &c ){ return c.num != 0; }) + 1;
+	}
+
+	bool empty()
+	{
+		return Cell::num == 0;
+	}
+
+	bool equal( uint n )
+	{
+		return Cell::num != 0 && Cell::num == n;
+	}
+
+	bool passable( uint n )
+	{
+		if (Cell::num != 0)
+			return false;
+
+		if (n == 0)
+			return true;
+
+		return (Cell::mask() & (1U << n)) != 0;
+	}
+
+	bool corrupt()
+	{
+		if (Cell::num == 0)
+			return Cell::mask() == 0;
+
+		return Cell::repeated();
+	}
+
+	bool allowed( uint n )
+	{
+		if (Cell::num != 0 || n == 0)
+			return false;
+
+		uint m = 1U << n;
+		if ((Cell::mask() & m) == 0)
+			return false;
+
+		return std::ranges::none_of(Cell::lst(), [m]( Cell &c ){ return c.num == 0 ? (c.mask() & ~m) == 0 : c.repeated(); });
+	}
+
+	bool accept( uint n )
+	{
+		return Cell::num == n || Cell::allowed(n);
+	}
+
+	uint sure( uint n = 0 )
+	{
+		if (Cell::num == 0 && n == 0)
+		{
+			for (uint v: Cell::Values(*this))
+				if (v != 0 && Cell::sure(v))
+					return v;
+
+			return 0;
+		}
+
+		if (!Cell::allowed(n)) return 0;
+		if ( Cell::len() == 1) return n;
+
+		if (std::ranges::none_of(Cell::row(), [n]( Cell &c ){ return c.allowed(n); })) return n;
+		if (std::ranges::none_of(Cell::col(), [n]( Cell &c ){ return c.allowed(n); })) return n;
+		if (std::ranges::none_of(Cell::seg(), [n]( Cell &c ){ return c.allowed(n); })) return n;
+
+		return 0;
+	}
+
+	void clear()
+	{
+		Cell::put(0);
+		Cell::immutable = false;
+	}
+
+	bool set( uint n )
+	{
+		if (Cell::immutable || (n != 0 && !Cell::allowed(n)))
+			return false;
+
+		Cell::put(n);
+		return true;
+	}
+
+	inline bool solve( bool check = false );
+
+	inline bool generate( Difficulty level, bool check = false );
+
+	static
+	bool by_length( Cell &a, Cell &b )
+	{
+		uint a_len = a.len();
+		uint b_len = b.len();
+
+		return a.num == 0 &&
+		      (b.num != 0 || a_len <  b_len ||
+		                    (a_len == b_len && a.range() < b.range()));
+	}
+
+	static
+	bool by_solid( Cell &a, Cell &b )
+	{
+		return a.solid() > b.solid();
+	}
+
+	template<class T> friend
+	std::basic_ostream<T> &operator <<( std::basic_ostream<T> &out, const Cell &cell )
+	{
+		out << (cell.immutable ? ".123456789" : ".ABCDEFGHI")[cell.num];
+
+		return out;
+	}
+};
+
+class SudokuBoard: public cell_array
+{
+	friend class SudokuCell;
+
+	std::array<std::array<uint8_t, 10>, 27> cnt{}; // digit counters of 9 rows, 9 columns and 9 segments
+	std::array<uint, 27>                    msk{}; // 9-bit occupancy masks of the units (bit n for digit n)
+	uint                                    dup{0}; // number of repeated digits on the board
+	std::array<uint8_t, 81>                 len;    // cached length of every cell
+	std::array<uint8_t, 81>                 rng;    // cached range of every cell (sum of the lengths of its peers)
+	std::array<SudokuBits, 10>              lvl{};  // empty cells grouped by their length (bucket queue)
+	uint64_t                                zob{0}; // Zobrist hash of the filled cells
+
+	using Keys = std::array<std::array<uint64_t, 10>, 81>;
+
+public:
+
+	using Counts = std::array<std::array<uint8_t, 10>, 81>;
+
+	SudokuRandom rnd{}; // random stream of the board
+
+private:
+
+	static constexpr
+	Keys zobrist()
+	{
+		Keys result{};
+		uint64_t x = 0;
+		for (uint p = 0; p < 81; p++)
+		{
+			for (uint n = 1; n <= 9; n++)
+			{
+				// splitmix64
+				uint64_t z = (x += UINT64_C(0x9E3779B97F4A7C15));
+				z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+				z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+				result[p][n] = z ^ (z >> 31);
+			}
+		}
+		return result;
+	}
+
+	static const
+	Keys keys; // Zobrist keys of the (cell, digit) pairs; an empty cell adds nothing
+
+	static uint row( uint p ) { return SudokuLinks::table.unit[p][0]; }
+	static uint col( uint p ) { return SudokuLinks::table.unit[p][1]; }
+	static uint seg( uint p ) { return SudokuLinks::table.unit[p][2]; }
+
+	void insert( uint u, uint n )
+	{
+		if (SudokuBoard::cnt[u][n]++ == 0)
+			SudokuBoard::msk[u] |= 1U << n;
+		else
+			SudokuBoard::dup++;
+	}
+
+	void remove( uint u, uint n )
+	{
+		if (--SudokuBoard::cnt[u][n] == 0)
+			SudokuBoard::msk[u] &= ~(1U << n);
+		else
+			SudokuBoard::dup--;
+	}
+
+	uint used( uint p )
+	{
+		return SudokuBoard::msk[row(p)] | SudokuBoard::msk[col(p)] | SudokuBoard::msk[seg(p)];
+	}
+
+	uint count( uint p )
+	{
+		if (SudokuBoard::at(p).num != 0)
+			return 0;
+
+		return static_cast<uint>(std::popcount(~SudokuBoard::used(p) & 0x3FEU));
+	}
+
+	void update( uint p )
+	{
+		uint l = SudokuBoard::count(p);
+		if (l != SudokuBoard::len[p])
+		{
+			if (SudokuBoard::at(p).num == 0)
+			{
+				SudokuBoard::lvl[SudokuBoard::len[p]].reset(p);
+				SudokuBoard::lvl[l].set(p);
+			}
+
+			uint8_t d = static_cast<uint8_t>(l - SudokuBoard::len[p]);
+			SudokuBoard::len[p] = static_cast<uint8_t>(l);
+			for (uint q: SudokuLinks::table.lst[p])
+				SudokuBoard::rng[q] = static_cast<uint8_t>(SudokuBoard::rng[q] + d);
+		}
+	}
+
+	void put( uint p, uint n )
+	{
+		uint o = SudokuBoard::at(p).num;
+
+		if (o == 0)
+			SudokuBoard::lvl[SudokuBoard::len[p]].reset(p);
+
+		if (o != 0)
+		{
+			SudokuBoard::remove(row(p), o);
+			SudokuBoard::remove(col(p), o);
+			SudokuBoard::remove(seg(p), o);
+		}
+
+		if (n != 0)
+		{
+			SudokuBoard::insert(row(p), n);
+			SudokuBoard::insert(col(p), n);
+			SudokuBoard::insert(seg(p), n);
+		}
+
+		SudokuBoard::at(p).num = n;
+		SudokuBoard::zob ^= SudokuBoard::keys[p][o] ^ SudokuBoard::keys[p][n];
+
+		// only the cell and its peers can change their length;
+		// each change is passed on to the ranges of their own peers
+		SudokuBoard::update(p);
+		for (uint q: SudokuLinks::table.lst[p])
+			SudokuBoard::update(q);
+
+		if (n == 0)
+			SudokuBoard::lvl[SudokuBoard::len[p]].set(p);
+	}
+
+	bool repeated( uint p, uint n )
+	{
+		return SudokuBoard::dup != 0 &&
+		      (SudokuBoard::cnt[row(p)][n] > 1 || SudokuBoard::cnt[col(p)][n] > 1 || SudokuBoard::cnt[seg(p)][n] > 1);
+	}
+
+	uint backtrack( uint limit )
+	{
+		uint p = SudokuBoard::choose();
+		if (p == 81)
+			return 1;
+
+		SudokuCell &cell = SudokuBoard::at(p);
+		uint result = 0;
+		for (uint m = cell.mask(); m != 0 && result < limit; m &= m - 1)
+		{
+			cell.put(static_cast<uint>(std::countr_zero(m)));
+			result += SudokuBoard::backtrack(limit - result);
+		}
+
+		cell.put(0);
+		return result;
+	}
+
+	class Trail
+	{
+	public:
+
+		std::array<uint8_t, 81> pos{};  // cells filled by the search, in order
+		std::array<uint8_t, 81> grid{}; // the first solution found
+		uint top{0};
+		uint found{0};
+	};
+
+	void assign( Trail &t, uint p, uint n )
+	{
+		SudokuBoard::put(p, n);
+		t.pos[t.top++] = static_cast<uint8_t>(p);
+	}
+
+	void revert( Trail &t, uint mark )
+	{
+		while (t.top > mark)
+			SudokuBoard::put(t.pos[--t.top], 0);
+	}
+
+	// fill all naked singles (cells with one available value) and hidden singles
+	// (values with one available cell in a unit); false if a contradiction was found
+	bool singles( Trail &t )
+	{
+		for (;;)
+		{
+			if (SudokuBoard::lvl[0].any())
+				return false;
+
+			if (SudokuBoard::lvl[1].any())
+			{
+				uint p = SudokuBoard::lvl[1].first();
+				SudokuBoard::assign(t, p, static_cast<uint>(std::countr_zero(SudokuBoard::at(p).mask())));
+				continue;
+			}
+
+			bool changed = false;
+			for (uint u = 0; u < 27 && !changed; u++)
+			{
+				uint ones = 0, twos = 0;
+				for (uint p: SudokuLinks::table.area[u])
+				{
+					if (SudokuBoard::at(p).num == 0)
+					{
+						uint m = SudokuBoard::at(p).mask();
+						twos |= ones & m;
+						ones |= m;
+					}
+				}
+
+				if ((ones | SudokuBoard::msk[u]) != 0x3FE)
+					return false;
+
+				uint once = ones & ~twos;
+				if (once != 0)
+				{
+					for (uint p: SudokuLinks::table.area[u])
+					{
+						uint m = SudokuBoard::at(p).num == 0 ? SudokuBoard::at(p).mask() & once : 0;
+						if (m != 0)
+						{
+							SudokuBoard::assign(t, p, static_cast<uint>(std::countr_zero(m)));
+							changed = true;
+							break;
+						}
+					}
+				}
+			}
+
+			if (!changed)
+				return true;
+		}
+	}
+
+	// whether any solution of the layout can change any of the counts
+	bool open( const Counts &sols, const SudokuBits &area )
+	{
+		bool result = false;
+		area.for_each([this, &sols, &result]( uint p )
+		{
+			SudokuCell &c = SudokuBoard::at(p);
+			for (uint m = c.num != 0 ? 1U << c.num : c.mask(); m != 0 && !result; m &= m - 1)
+				result = sols[p][static_cast<uint>(std::countr_zero(m))] < 2;
+		});
+		return result;
+	}
+
+	// the same search enumerating all the solutions; the subtrees that cannot change any of the counts are skipped
+	bool tally( Trail &t, Counts &sols, const SudokuBits &area, uint64_t &nodes )
+	{
+		uint mark = t.top;
+		bool result = true;
+
+		if (SudokuBoard::singles(t) && SudokuBoard::open(sols, area))
+		{
+			uint p = SudokuBoard::choose();
+			if (nodes-- == 0)
+			{
+				result = false;
+			}
+			else
+			if (p == 81)
+			{
+				area.for_each([this, &sols]( uint q )
+				{
+					uint8_t &n = sols[q][SudokuBoard::at(q).num];
+					if (n < 2) n++;
+				});
+			}
+			else
+			{
+				for (uint m = SudokuBoard::at(p).mask(); m != 0 && result; m &= m - 1)
+				{
+					uint q = t.top;
+					SudokuBoard::assign(t, p, static_cast<uint>(std::countr_zero(m)));
+					result = SudokuBoard::tally(t, sols, area, nodes);
+					SudokuBoard::revert(t, q);
+				}
+			}
+		}
+
+		SudokuBoard::revert(t, mark);
+		return result;
+	}
+
+	// singles at every node, then branch on the most constrained cell; the board is restored from the trail
+	uint propagate( Trail &t, uint limit )
+	{
+		uint mark = t.top;
+		uint result = 0;
+
+		if (SudokuBoard::singles(t))
+		{
+			uint p = SudokuBoard::choose();
+			if (p == 81)
+			{
+				if (t.found++ == 0)
+					for (SudokuCell &c: *this)
+						t.grid[c.pos] = static_cast<uint8_t>(c.num);
+				result = 1;
+			}
+			else
+			{
+				for (uint m = SudokuBoard::at(p).mask(); m != 0 && result < limit; m &= m - 1)
+				{
+					uint q = t.top;
+					SudokuBoard::assign(t, p, static_cast<uint>(std::countr_zero(m)));
+					result += SudokuBoard::propagate(t, limit - result);
+					SudokuBoard::revert(t, q);
+				}
+			}
+		}
+
+		SudokuBoard::revert(t, mark);
+		return result;
+	}
+
+public:
+
+	// resumable constraint propagation search: the state lives in a preallocated stack, so the search
+	// can be run for a number of nodes, paused and resumed later; while paused, the board holds the
+	// partial layout of the search and must not be changed; the board is restored when the search ends
+	class Search
+	{
+		struct Frame
+		{
+			uint8_t  pos;    // branch cell
+			uint16_t mask;   // values not tried yet
+			uint8_t  mark;   // trail position before the singles of the node
+			uint8_t  branch; // trail position before the branch value
+		};
+
+		SudokuBoard &tab;
+		Trail trail;
+		std::array<Frame, 81> stack;
+		uint depth;
+		uint limit;
+		bool descend;
+		bool finished;
+
+	public:
+
+		uint64_t nodes;
+
+		Search( SudokuBoard &_t, uint _l = 1 ): tab{_t}, trail{}, stack{}, depth{0}, limit{_l}, descend{true}, finished{_l == 0 || _t.dup != 0}, nodes{0} {}
+		~Search() { Search::cancel(); }
+
+		Search( const Search & ) = delete;
+		Search &operator=( const Search & ) = delete;
+
+		// run the search for at most 'budget' nodes; true if the search is finished
+		bool run( uint64_t budget = UINT64_MAX )
+		{
+			while (!Search::finished)
+			{
+				if (Search::descend)
+				{
+					if (budget-- == 0)
+						return false;
+
+					Search::nodes++;
+					Search::descend = false;
+
+					uint mark = Search::trail.top;
+					if (!Search::tab.singles(Search::trail))
+					{
+						Search::tab.revert(Search::trail, mark);
+						continue;
+					}
+
+					uint p = Search::tab.choose();
+					if (p == 81)
+					{
+						if (Search::trail.found++ == 0)
+							for (SudokuCell &c: Search::tab)
+								Search::trail.grid[c.pos] = static_cast<uint8_t>(c.num);
+						Search::tab.revert(Search::trail, mark);
+						continue;
+					}
+
+					Search::stack[Search::depth++] = { static_cast<uint8_t>(p), static_cast<uint16_t>(Search::tab.at(p).mask()), static_cast<uint8_t>(mark), static_cast<uint8_t>(Search::trail.top) };
+				}
+				else
+				if (Search::depth == 0)
+				{
+					Search::finished = true;
+				}
+				else
+				{
+					Frame &f = Search::stack[Search::depth - 1];
+					Search::tab.revert(Search::trail, f.branch);
+					if (f.mask == 0 || Search::trail.found >= Search::limit)
+					{
+						Search::tab.revert(Search::trail, f.mark);
+						Search::depth--;
+						continue;
+					}
+
+					uint v = static_cast<uint>(std::countr_zero(f.mask));
+					f.mask = static_cast<uint16_t>(f.mask & (f.mask - 1));
+					Search::tab.assign(Search::trail, f.pos, v);
+					Search::descend = true;
+				}
+			}
+
+			return true;
+		}
+
+		// stop the search and restore the board
+		void cancel()
+		{
+			Search::tab.revert(Search::trail, 0);
+			Search::depth = 0;
+			Search::finished = true;
+		}
+
+		bool done()      const { return Search::finished; }
+		uint solutions() const { return Search::trail.found; }
+
+		// value of the cell in the first solution found
+		uint get( uint p ) const { return Search::trail.grid[p]; }
+	};
+
+protected:
+
+	uint64_t key() const { return SudokuBoard::zob; }
+
+	static
+	SudokuDLX &dlx()
+	{
+		static thread_local SudokuDLX dlx{};
+		return dlx;
+	}
+
+public:
+
+	Engine engine{Engine::Backtracking};
+
+	SudokuBoard()
+	{
+		SudokuBoard::len.fill(9);
+		SudokuBoard::rng.fill(9 * 20);
+		SudokuBoard::lvl[9] = SudokuBits::all();
+	}
+
+	// whether the layout can be solved (the backtracking search starts from the cell p);
+	// if fill, the solution found is left on the board, otherwise the board is not changed
+	template<Engine E>
+	bool find( uint p, bool fill )
+	{
+		if constexpr (E == Engine::DLX)
+		{
+			SudokuDLX &x = SudokuBoard::dlx();
+			if (x.solve(*this) == 0)
+				return false;
+
+			if (fill)
+				for (SudokuCell &c: *this)
+					c.put(x.get(c.pos));
+
+			return true;
+		}
+		else
+		if constexpr (E == Engine::Propagation)
+		{
+			Trail t{};
+			if (SudokuBoard::dup != 0 || SudokuBoard::propagate(t, 1) == 0)
+				return false;
+
+			if (fill)
+				for (SudokuCell &c: *this)
+					c.put(t.grid[c.pos]);
+
+			return true;
+		}
+		else
+		if constexpr (E == Engine::Iterative)
+		{
+			auto x = Search(*this);
+			if (!x.run() || x.solutions() == 0)
+				return false;
+
+			if (fill)
+				for (SudokuCell &c: *this)
+					c.put(x.get(c.pos));
+
+			return true;
+		}
+		else
+		{
+			return SudokuBoard::at(p).solve(!fill);
+		}
+	}
+
+	bool find( uint p, bool fill )
+	{
+		switch (SudokuBoard::engine)
+		{
+		case Engine::DLX:         return SudokuBoard::find<Engine::DLX>(p, fill);
+		case Engine::Propagation: return SudokuBoard::find<Engine::Propagation>(p, fill);
+		case Engine::Iterative:   return SudokuBoard::find<Engine::Iterative>(p, fill);
+		default:                  return SudokuBoard::find<Engine::Backtracking>(p, fill);
+		}
+	}
+
+	// number of solutions of the layout, the search stops as soon as the limit is reached; the board is not changed
+	template<Engine E>
+	uint count_solutions( uint limit = 2 )
+	{
+		if (SudokuBoard::dup != 0 || limit == 0)
+			return 0;
+
+		if constexpr (E == Engine::DLX)
+			return SudokuBoard::dlx().solve(*this, limit);
+		else
+		if constexpr (E == Engine::Propagation)
+		{
+			Trail t{};
+			return SudokuBoard::propagate(t, limit);
+		}
+		else
+		if constexpr (E == Engine::Iterative)
+		{
+			auto x = Search(*this, limit);
+			x.run();
+			return x.solutions();
+		}
+		else
+			return SudokuBoard::backtrack(limit);
+	}
+
+	uint count_solutions( uint limit = 2 )
+	{
+		switch (SudokuBoard::engine)
+		{
+		case Engine::DLX:         return SudokuBoard::count_solutions<Engine::DLX>(limit);
+		case Engine::Propagation: return SudokuBoard::count_solutions<Engine::Propagation>(limit);
+		case Engine::Iterative:   return SudokuBoard::count_solutions<Engine::Iterative>(limit);
+		default:                  return SudokuBoard::count_solutions<Engine::Backtracking>(limit);
+		}
+	}
+
+	// for every empty cell of the area and every value: number of the solutions of the layout with the value
+	// in the cell (0, 1 or 2: more than one); false if the search ran out of nodes, then only the counts
+	// equal to 2 are certain; the board is not changed
+	bool count_solutions( Counts &sols, const SudokuBits &area, uint64_t nodes = UINT64_MAX )
+	{
+		sols = Counts{};
+		if (SudokuBoard::dup != 0)
+			return true;
+
+		Trail t{};
+		return SudokuBoard::tally(t, sols, area, nodes);
+	}
+
+	// the most constrained empty cell of the area: the shortest one, then the one with the smallest range,
+	// then the first one (the same choice as std::min_element with SudokuCell::by_length); 81 if there is none
+	uint choose( const SudokuBits &area = SudokuBits::all() )
+	{
+		for (const SudokuBits &l: SudokuBoard::lvl)
+		{
+			SudokuBits bits = l & area;
+			if (bits.any())
+			{
+				uint result = 81;
+				bits.for_each([this, &result]( uint p )
+				{
+					if (result == 81 || SudokuBoard::rng[p] < SudokuBoard::rng[result])
+						result = p;
+				});
+				return result;
+			}
+		}
+
+		return 81;
+	}
+};
+
+static_assert(std::is_trivially_copyable_v<SudokuBoard>);
+
+inline constexpr
+SudokuBoard::Keys SudokuBoard::keys = SudokuBoard::zobrist();
+
+SudokuBoard &SudokuCell::tab()
+{
+	return *static_cast<SudokuBoard *>(reinterpret_cast<cell_array *>(this - Cell::pos));
+}
+
+uint SudokuCell::mask()
+{
+	return ~Cell::tab().used(Cell::pos) & 0x3FE;
+}
+
+void SudokuCell::put( uint n )
+{
+	if (Cell::num != n)
+		Cell::tab().put(Cell::pos, n);
+}
+
+uint SudokuCell::len()
+{
+	return Cell::tab().len[Cell::pos];
+}
+
+uint SudokuCell::range()
+{
+	return Cell::tab().rng[Cell::pos];
+}
+
+bool SudokuCell::repeated()
+{
+	return Cell::num != 0 && Cell::tab().repeated(Cell::pos, Cell::num);
+}
+
+bool SudokuCell::solve( bool check )
+{
+	SudokuBoard &tab = Cell::tab();
+	uint p = tab.choose(SudokuLinks::table.bits[Cell::pos]);
+	if (p == 81)
+	{
+		p = tab.choose();
+		if (p == 81)
+			return true;
+	}
+
+	Cell &cell = tab[p];
+	for (uint v: Cell::Values(cell, &tab.rnd))
+	{
+		if (v != 0 && (cell.put(v), cell.solve(check)))
+		{
+			if (check)
+				cell.put(0);
+
+			return true;
+		}
+	}
+
+	cell.put(0);
+	return false;
+}
+
+bool SudokuCell::generate( Difficulty level, bool check )
+{
+	if (Cell::num == 0 || Cell::immutable)
+		return false;
+
+	uint n = Cell::num;
+
+	Cell::put(0);
+	if (Cell::sure(n))
+		return true;
+
+	Cell::put(n);
+	if (level == Difficulty::Easy && !check)
+		return false;
+
+	for (uint v: Cell::Values(*this))
+	{
+		if (v != 0 && (Cell::put(v), Cell::tab().find(Cell::pos, false)))
+		{
+			Cell::put(n);
+			return false;
+		}
+	}
+
+	Cell::put(0);
+	return true;
+}
+
+class Sudoku: public SudokuBoard
+{
+	using Cell = SudokuCell;
+
+	static const
+	std::vector<std::basic_string<TCHAR>> extreme;
+
+	static const
+	std::basic_string<TCHAR> html;
+
+	std::list<std::pair<uint, uint>> mem; // position and previous value of the changed cell
+
+	class Backup: public std::array<std::tuple<Cell *, uint, bool>, 81>
+	{
+	public:
+
+		Backup( cell_array *tab )
+		{
+			std::transform(std::begin(*tab), std::end(*tab), Backup::begin(), []( Cell &c )
+			{
+				return std::make_tuple(&c, c.num, c.immutable);
+			});
+		}
+
+		void reload()
+		{
+			std::for_each(Backup::begin(), Backup::end(), []( std::tuple<Cell *, uint, bool> &t )
+			{
+				Cell *c = std::get<Cell *>(t);
+				std::get<uint>(t) = c->num;
+				std::get<bool>(t) = c->immutable;
+			});
+		}
+
+		void restore()
+		{
+			std::for_each(Backup::begin(), Backup::end(), []( std::tuple<Cell *, uint, bool> &t )
+			{
+				Cell *c = std::get<Cell *>(t);
+				c->put(std::get<uint>(t));
+				c->immutable = std::get<bool>(t);
+			});
+		}
+
+		bool changed()
+		{
+			return std::any_of(Backup::begin(), Backup::end(), []( std::tuple<Cell *, uint, bool> &t )
+			{
+				Cell *c = std::get<Cell *>(t);
+				return c->num != std::get<uint>(t);
+			});
+		}
+
+		uint len()
+		{
+			return std::count_if(Backup::begin(), Backup::end(), []( std::tuple<Cell *, uint, bool> &t )
+			{
+				return std::get<uint>(t) != 0;
+			});
+		}
+	};
+
+	class Temp: public Sudoku::Backup
+	{
+	public:
+
+		Temp( cell_array *tab ): Sudoku::Backup(tab) {}
+		~Temp() { Sudoku::Backup::restore(); }
+
+		bool reset()
+		{
+			return std::all_of(Sudoku::Backup::begin(), Sudoku::Backup::end(), []( std::tuple<Cell *, uint, bool> &t )
+			{
+				Cell *c = std::get<Cell *>(t);
+				return c->set(std::get<uint>(t));
+			});
+		}
+	};
+
+	class Random: public std::vector<cell_ref>
+	{
+	public:
+
+		Random( SudokuBoard *tab ): std::vector<cell_ref>(std::begin(*tab), std::end(*tab)), rnd{&tab->rnd}
+		{
+			std::shuffle(Random::begin(), Random::end(), *Random::rnd);
+		}
+
+		Cell& operator()()
+		{
+			return Random::at(Random::rnd->below(static_cast<uint>(Random::size())));
+		}
+
+	private:
+
+		SudokuRandom *rnd;
+	};
+
+	class Sorted: public std::vector<cell_ref>
+	{
+	public:
+
+		Sorted( cell_array *tab, bool(*compare)(Cell &, Cell&) ): std::vector<cell_ref>(std::begin(*tab), std::end(*tab))
+		{
+			std::sort(Sorted::begin(), Sorted::end(), compare);
+		}
+	};
+
+public:
+
+	// ratings of the partial layouts already parsed, keyed by the Zobrist hash of the filled cells;
+	// two-way buckets, the most recent entry comes first and the older one is replaced
+	class Memo
+	{
+		struct Entry
+		{
+			uint64_t key;
+			int      value;
+			bool     used;
+		};
+
+		std::vector<Entry> tab;
+		uint shift;
+
+		size_t slot( uint64_t key ) const
+		{
+			return static_cast<size_t>(key >> Memo::shift) * 2;
+		}
+
+	public:
+
+		uint64_t hits{0};
+		uint64_t misses{0};
+
+		// 2^bits buckets of two entries
+		Memo( uint bits = 18 ): tab(size_t{2} << bits, Entry{0, 0, false}), shift{64 - bits} {}
+
+		bool find( uint64_t key, int &value )
+		{
+			size_t i = Memo::slot(key);
+			for (size_t j = i; j < i + 2; j++)
+			{
+				if (Memo::tab[j].used && Memo::tab[j].key == key)
+				{
+					value = Memo::tab[j].value;
+					Memo::hits++;
+					return true;
+				}
+			}
+			Memo::misses++;
+			return false;
+		}
+
+		void store( uint64_t key, int value )
+		{
+			size_t i = Memo::slot(key);
+			if (!Memo::tab[i].used || Memo::tab[i].key != key)
+				Memo::tab[i + 1] = Memo::tab[i];
+			Memo::tab[i] = Entry{key, value, true};
+		}
+
+		void clear()
+		{
+			std::fill(Memo::tab.begin(), Memo::tab.end(), Entry{0, 0, false});
+			Memo::hits = Memo::misses = 0;
+		}
+	};
+
+	// limits of a single rating by the search grader; zero means no limit
+	struct Budget
+	{
+		uint64_t nodes{0};  // layouts parsed
+		uint     ms{0};     // milliseconds
+	};
+
+	// the workers rate the branches of the first fork only, so their tables are smaller
+	static
+	Memo &memo()
+	{
+		static thread_local Memo memo{SudokuWorkers::inside() ? 16U : 18U};
+		return memo;
+	}
+
+	// the threads of the parallel rating and raise, shared by all the boards
+	static
+	SudokuWorkers &workers()
+	{
+		static SudokuWorkers workers{};
+		return workers;
+	}
+
+	// logical grade of the current layout
+	SudokuLogic::Grade grade()
+	{
+		static thread_local SudokuLogic logic{};
+		return logic.grade(*this);
+	}
+
+	Difficulty level;
+	int        rating;    // lower bound of the rating, if truncated
+	int        upper;     // upper bound of the rating (INT_MAX: unknown)
+	bool       truncated; // the budget ran out before the rating was complete
+	uint32_t   signature;
+	uint64_t   digest;    // wide signature: 64-bit hash of the givens
+	uint       jobs{1};   // threads used by the rating
+	Grader     grader{Grader::Search};
+	Budget     budget{};
+	bool       pooled{false};   // every level (not only Extreme) is drawn from the pool, if it has boards of the level
+	int        target{INT_MIN}; // weight of interest: a rating reaching it is truncated until the board passes the test
+
+	static bool castagnoli; // signatures by CRC-32C (accelerated), the default CRC-32 keeps the ones of the existing board files
+	static std::basic_string<TCHAR> pool_file; // read at the first draw from the pool, so it must be set before
+
+	Sudoku( Difficulty l = Difficulty::Easy ): mem{}, level{l}, rating{0}, upper{0}, truncated{false}, signature{0}, digest{0}
+	{
+		for (Cell &cell: *this)
+		{
+			auto pos = &cell - this->cell_array::data();
+			cell.init(static_cast<uint>(pos));
+		}
+	}
+
+	uint len()
+	{
+		return std::count_if(Sudoku::begin(), Sudoku::end(), []( Cell &c ){ return c.num != 0; });
+	}
+
+	uint count( uint n )
+	{
+		return std::count_if(Sudoku::begin(), Sudoku::end(), [n]( Cell &c ){ return c.num == n; });
+	}
+
+	bool empty()
+	{
+		return std::all_of(Sudoku::begin(), Sudoku::end(), []( Cell &c ){ return c.empty(); });
+	}
+
+	bool corrupt()
+	{
+		for (auto i = Sudoku::begin(); i != Sudoku::end(); i += 9)
+			for (uint n = 1; n <= 9; ++n)
+				if (std::none_of(i, i + 9, [n]( Cell &c ){ return c.accept(n); }))
+					return true;
+
+		return std::any_of(Sudoku::begin(), Sudoku::end(), []( Cell &c ){ return c.corrupt(); });
+	}
+
+	bool solved()
+	{
+		return std::none_of(Sudoku::begin(), Sudoku::end(), []( Cell &c ){ return c.empty() || c.corrupt(); });
+	}
+
+	bool set( Cell *cell, uint n, Force force = Force::Direct )
+	{
+		if (cell == nullptr)
+			return false;
+
+		uint t = cell->num;
+
+		if (t == n)
+			return false;
+
+		switch (force)
+		{
+		case Force::Direct:
+			if (cell->immutable)
+				return false;
+			cell->put(n);
+			break;
+		case Force::Careful:
+			if (!cell->passable(n))
+				return false;
+			cell->put(n);
+			break;
+		case Force::Safe:
+			if (!cell->set(n))
+				return false;
+			break;
+		}
+
+		Sudoku::mem.emplace_back(cell->pos, t);
+		Sudoku::rating = 0;
+		return true;
+	}
+
+	void clear( bool deep = true )
+	{
+		for (Cell &c: *this)
+			c.clear();
+
+		if (deep)
+		{
+			Sudoku::rating = 0;
+			Sudoku::signature = 0;
+			Sudoku::digest = 0;
+			if (Sudoku::level > Difficulty::Easy && Sudoku::level < Difficulty::Extreme)
+				Sudoku::level = Difficulty::Medium;
+		}
+	}
+
+	void discard()
+	{
+		for (Cell &c: *this)
+			c.immutable = false;
+	}
+
+	void accept( bool estimate = false, Difficulty difficulty = Difficulty::Any )
+	{
+		for (Cell &c: *this)
+			c.immutable = c.num != 0;
+
+		if (difficulty != Difficulty::Any)
+			Sudoku::level = difficulty;
+
+		Sudoku::specify_layout(estimate);
+		Sudoku::mem.clear();
+	}
+
+	void init( std::basic_string<TCHAR> txt )
+	{
+		Sudoku::clear();
+
+		for (Cell &c: *this)
+		{
+			if (c.pos < txt.size())
+			{
+				int x = txt[c.pos] - _T('0');
+				c.set(x >= 0 && x <= 9 ? static_cast<uint>(x) : 0U);
+			}
+		}
+
+		Sudoku::accept();
+
+		for (Cell &c: *this)
+		{
+			if (c.pos < txt.size())
+			{
+				int x = txt[c.pos] - _T('@');
+				c.set(x >= 0 && x <= 9 ? static_cast<uint>(x) : 0U);
+			}
+		}
+	}
+
+	// a board of the pool, with its level and rating (nothing is rated again); false if the record is not valid
+	bool init( const SudokuPool::Record &r )
+	{
+		if (!r.valid())
+			return false;
+
+		Sudoku::clear();
+
+		for (Cell &c: *this)
+		{
+			c.put(r.get(c.pos));
+			c.immutable = c.num != 0;
+		}
+
+		Sudoku::level = static_cast<Difficulty>(r.level);
+		Sudoku::truncated = false;
+		Sudoku::upper = Sudoku::rating = r.rating;
+		Sudoku::calculate_signature();
+		Sudoku::mem.clear();
+		return true;
+	}
+
+	SudokuPool::Record record()
+	{
+		SudokuPool::Record r{};
+		for (Cell &c: *this)
+			r.set(c.pos, c.num);
+		r.level  = static_cast<uint8_t>(Sudoku::level);
+		r.len    = static_cast<uint16_t>(Sudoku::len());
+		r.rating = Sudoku::rating;
+		return r;
+	}
+
+	// the pool of boards, mapped from the pool file (if there is one) at the first use
+	static SudokuPool &pool()
+	{
+		static SudokuPool pool{Sudoku::pool_file.c_str()};
+		return pool;
+	}
+
+	void again()
+	{
+		for (Cell &c: *this)
+			if (!c.immutable)
+				c.put(0);
+
+		Sudoku::mem.clear();
+	}
+
+private:
+
+	void shuffle()
+	{
+		Sudoku::transform(Sudoku::symmetry());
+	}
+
+public:
+
+	// an element of the symmetry group of the board (relabeling of the digits, order of the bands, of the
+	// rows within a band, of the stacks, of the columns within a stack, transposition) composed into one
+	// permutation of the cells: the cell p takes the relabeled digit of the cell map[p]
+	struct Symmetry
+	{
+		std::array<uint8_t, 81> map;
+		std::array<uint8_t, 10> dig;
+	};
+
+	// a random element of the symmetry group, every element equally likely
+	Symmetry symmetry()
+	{
+		auto lines = [this]( uint8_t *x )
+		{
+			uint8_t band[3] = { 0, 1, 2 };
+			std::shuffle(band, band + 3, Sudoku::rnd);
+			for (uint b = 0; b < 3; b++)
+			{
+				uint8_t line[3] = { 0, 1, 2 };
+				std::shuffle(line, line + 3, Sudoku::rnd);
+				for (uint i = 0; i < 3; i++)
+					x[b * 3 + i] = static_cast<uint8_t>(band[b] * 3 + line[i]);
+			}
+		};
+
+		uint8_t row[9], col[9];
+		lines(row);
+		lines(col);
+		bool t = Sudoku::rnd.below(2) != 0;
+
+		Symmetry s;
+		std::iota(s.dig.begin(), s.dig.end(), static_cast<uint8_t>(0));
+		std::shuffle(s.dig.begin() + 1, s.dig.end(), Sudoku::rnd);
+		for (uint r = 0; r < 9; r++)
+			for (uint c = 0; c < 9; c++)
+				s.map[r * 9 + c] = static_cast<uint8_t>(t ? col[c] * 9 + row[r] : row[r] * 9 + col[c]);
+		return s;
+	}
+
+	// the layout (with its immutable cells) transformed in one pass; the rating, the level
+	// and the signature are the invariants of the transformation, so they are kept,
+	// only the wide signature follows the layout
+	void transform( const Symmetry &s )
+	{
+		std::array<uint8_t, 81> num;
+		std::array<bool, 81>    imm;
+		for (Cell &c: *this)
+		{
+			num[c.pos] = static_cast<uint8_t>(c.num);
+			imm[c.pos] = c.immutable;
+		}
+
+		for (Cell &c: *this)
+		{
+			c.put(s.dig[num[s.map[c.pos]]]);
+			c.immutable = imm[s.map[c.pos]];
+		}
+
+		if (Sudoku::signature != 0)
+			Sudoku::calculate_digest();
+		Sudoku::mem.clear();
+	}
+
+	// the built-in extreme boards, the seeds of the isomorphs
+	static const std::vector<std::basic_string<TCHAR>> &extremes() { return Sudoku::extreme; }
+
+	// k different isomorphs of the layout drawn at random (fewer only if the draws keep repeating)
+	std::vector<Sudoku> isomorphs( uint k )
+	{
+		auto result = std::vector<Sudoku>();
+		auto seen   = std::set<std::array<uint8_t, 81>>();
+
+		for (uint miss = 0; result.size() < k && miss < 64; )
+		{
+			auto tmp = *this;
+			tmp.transform(Sudoku::symmetry());
+
+			std::array<uint8_t, 81> key;
+			for (Cell &c: tmp)
+				key[c.pos] = static_cast<uint8_t>(c.num);
+
+			if (!seen.insert(key).second)
+			{
+				miss++;
+				continue;
+			}
+
+			result.push_back(tmp);
+			miss = 0;
+		}
+
+		return result;
+	}
+
+private:
+
+	int solvable()
+	{
+		if (Sudoku::corrupt())
+			return -2;
+
+		auto tmp = Sudoku::Temp(this);
+		Sudoku::clear(false);
+
+		if (!tmp.reset())
+			return -2;
+
+		return 0;
+	}
+
+	int correct()
+	{
+		switch (Sudoku::count_solutions(2))
+		{
+		case 0:  return -2;
+		case 1:  return  0;
+		default: return -1;
+		}
+	}
+
+	bool simplify( bool confirm = false )
+	{
+		bool result = false;
+
+		bool simplified;
+		do
+		{
+			simplified = false;
+			for (Cell &c: *this)
+			{
+				if (c.num == 0 && (c.put(c.sure(0)), c.num != 0))
+				{
+					if (confirm)
+						c.immutable = true;
+					result = simplified = true;
+				}
+			}
+		}
+		while (simplified);
+
+		if (confirm)
+		{
+			Sudoku::level = Difficulty::Expert;
+			Sudoku::rating = 0;
+			Sudoku::signature = 0;
+			Sudoku::digest = 0;
+		}
+
+		return result;
+	}
+
+	// weight of the rating or of its upper bound
+	int weight( bool bound = false )
+	{
+		int r = bound ? Sudoku::upper : Sudoku::rating;
+		if (r == INT_MAX)
+			return INT_MAX;
+		return r - static_cast<int>(Sudoku::len()) * 25;
+	}
+
+public:
+
+	template<Engine E>
+	void solve()
+	{
+		if (Sudoku::solvable() == 0)
+		{
+			Sudoku::find<E>(std::max_element(Sudoku::begin(), Sudoku::end(), Cell::by_length)->pos, true);
+			Sudoku::mem.clear();
+		}
+	}
+
+	void solve()
+	{
+		switch (Sudoku::engine)
+		{
+		case Engine::DLX:         Sudoku::solve<Engine::DLX>();          break;
+		case Engine::Propagation: Sudoku::solve<Engine::Propagation>();  break;
+		case Engine::Iterative:   Sudoku::solve<Engine::Iterative>();    break;
+		default:                  Sudoku::solve<Engine::Backtracking>(); break;
+		}
+	}
+
+	void generate( Difficulty difficulty = Difficulty::Any )
+	{
+		if (difficulty != Difficulty::Any)
+			Sudoku::level = difficulty;
+
+		if (Sudoku::level == Difficulty::Extreme || Sudoku::pooled)
+		{
+			auto &p = Sudoku::pool();
+			auto  n = std::min(p.size(static_cast<uint>(Sudoku::level)), static_cast<size_t>(UINT_MAX));
+			if (n > 0 && Sudoku::init(p.begin(static_cast<uint>(Sudoku::level))[Sudoku::rnd.below(static_cast<uint>(n))]))
+			{
+				Sudoku::shuffle();
+				return;
+			}
+		}
+
+		if (Sudoku::level == Difficulty::Extreme)
+		{
+			Sudoku::init(Sudoku::extreme[Sudoku::rnd.below(static_cast<uint>(Sudoku::extreme.size()))]);
+			Sudoku::shuffle();
+		}
+		else
+		{
+			auto lst = Sudoku::Random(this);
+			Sudoku::clear();
+			lst().solve();
+			for (Cell &c: lst)
+				c.generate(Sudoku::level);
+			Sudoku::accept();
+		}
+	}
+
+	// the layout (and the state) of the copy, but not its random stream, so that the stream is not replayed
+	void restore( const Sudoku &sudoku )
+	{
+		auto r = Sudoku::rnd;
+		*this = sudoku;
+		Sudoku::rnd = r;
+	}
+
+	// count: number of the solutions of the layout (2: more than one), if already known (UINT_MAX otherwise);
+	// a layout with other than one solution is rejected at once, otherwise it is accept(true) without the solver
+	bool verify( bool forced, uint count = UINT_MAX )
+	{
+		if (count != UINT_MAX && count != 1)
+			return false;
+
+		Difficulty current = Sudoku::level;
+		if (count == 1)
+		{
+			for (Cell &c: *this)
+				c.immutable = c.num != 0;
+
+			Sudoku::truncated = false;
+			Sudoku::upper = Sudoku::rating = 0;
+			Sudoku::calculate_level();
+			Sudoku::calculate_signature(true);
+			Sudoku::mem.clear();
+		}
+		else
+			Sudoku::accept(true);
+
+		if (Sudoku::rating >= 0 && (!forced || (Sudoku::level >= current && Sudoku::level >= Difficulty::Hard)))
+		{
+			if (forced && Sudoku::level == Difficulty::Hard && Sudoku::level > current)
+				Sudoku::simplify(true);
+			return true;
+		}
+		Sudoku::level = current;
+		return false;
+	}
+
+	// ci and cj were cleared: fill one empty cell (ci, cj or linked to them, taken in the given order)
+	// so that the layout stays correct and passes verify; false if there is no such cell
+	bool refill( Cell &ci, Cell &cj, const std::vector<cell_ref> &order, bool forced )
+	{
+		// every layout tried below is this one with a single cell filled, so the solutions
+		// of this layout are enumerated once instead of solving every one of them
+		auto area = SudokuBits();
+		for (Cell &c: *this)
+			if (c.num == 0 && (&c == &ci || &c == &cj || c.linked(&ci) || c.linked(&cj)))
+				area.set(c.pos);
+		auto sols  = Counts{};
+		bool known = Sudoku::count_solutions(sols, area, 1U << 20);
+
+		for (const Cell &o: order)
+		{
+			Cell &cell = Sudoku::at(o.pos);
+			if (cell.num != 0) continue;
+			if (&cell != &ci && &cell != &cj && !cell.linked(&ci) && !cell.linked(&cj)) continue;
+
+			for (uint v: Cell::Values(cell))
+			{
+				if (v == 0)
+					continue;
+
+				uint count = known || sols[cell.pos][v] == 2 ? sols[cell.pos][v] : UINT_MAX;
+				if (cell.put(v), Sudoku::verify(forced, count))
+					return true;
+			}
+
+			cell.put(0);
+		}
+
+		return false;
+	}
+
+	// the pairs (ci, cj) are tried in batches, every pair on its own copy of the board; the random order of
+	// the cells is drawn for all the pairs of the batch before, and the first pair (in the serial order)
+	// that succeeded is committed, so the result depends on the seed only, not on the number of threads
+	// (a single thread takes the same path and tries the pairs of the batch one after another)
+	bool raise_step( std::vector<cell_ref> &vec, bool forced )
+	{
+		auto pairs = std::vector<std::pair<uint, uint>>();
+		for (auto i = vec.begin(); i != vec.end(); ++i)
+			for (auto j = i + 1; j != vec.end(); ++j)
+				if (i->get().num != 0 && j->get().num != 0)
+					pairs.emplace_back(i->get().pos, j->get().pos);
+
+		const size_t batch = 64;
+		for (size_t first = 0; first < pairs.size(); first += batch)
+		{
+			size_t size = std::min(batch, pairs.size() - first);
+			auto order = std::vector<std::vector<cell_ref>>();
+			for (size_t k = 0; k < size; k++)
+				order.emplace_back(Sudoku::Random(this));
+
+			auto board = std::vector<std::optional<Sudoku>>(size);
+			auto found = std::atomic<size_t>{size};
+			auto next  = std::atomic<size_t>{0};
+			auto work  = [this, &pairs, &order, &board, &found, &next, first, size, forced]
+			{
+				for (size_t k = next++; k < size && k < found; k = next++)
+				{
+					auto tmp = *this;
+					Cell &ci = tmp.at(pairs[first + k].first);
+					Cell &cj = tmp.at(pairs[first + k].second);
+					ci.put(0);
+					cj.put(0);
+					if (tmp.refill(ci, cj, order[k], forced))
+					{
+						board[k] = tmp;
+						for (size_t f = found; k < f && !found.compare_exchange_weak(f, k); );
+					}
+				}
+			};
+
+			Sudoku::workers().run(static_cast<uint>(std::min<size_t>(Sudoku::jobs, size)), work);
+
+			if (found < size)
+			{
+				Sudoku::restore(*board[found]);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// a layout of at most n clues with the solution of the current one, searched for ms milliseconds
+	// by hitting the unavoidable sets of the grid; the layout is left unchanged if none was found;
+	// the new layout is not rated, that is left to raise()
+	bool reduce( uint n, uint ms )
+	{
+		if (Sudoku::len() <= n)
+			return false;
+
+		auto tmp = *this;
+		tmp.solve<Engine::Propagation>();
+
+		SudokuHitting::Grid grid;
+		for (Cell &c: tmp)
+			grid[c.pos] = static_cast<uint8_t>(c.num);
+
+		auto hit = SudokuHitting(grid);
+		if (!hit.search(n, ms, static_cast<uint32_t>(Sudoku::rnd()), grid))
+			return false;
+
+		Sudoku::clear();
+		for (Cell &c: *this)
+		{
+			c.put(grid[c.pos]);
+			c.immutable = c.num != 0;
+		}
+		Sudoku::mem.clear();
+		return true;
+	}
+
+	void raise( bool force = true, bool show = true )
+	{
+		Sudoku::accept(false, Difficulty::Medium);
+		if (show)
+			std::cerr << *this << std::endl;
+
+		if (force && Sudoku::level == Difficulty::Hard)
+		{
+			Sudoku::simplify(true);
+			if (show)
+			{
+				if (Sudoku::len() <= 20)
+					accept();
+				std::cerr << *this << std::endl;
+			}
+		}
+
+		bool forced = false;
+		bool success = true;
+		while (success && Sudoku::len() > 17)
+		{
+			forced = forced || (force && (Sudoku::level >= Difficulty::Hard || Sudoku::len() <= 30));
+			success = false;
+			auto vec = Sudoku::Sorted(this, Cell::by_solid);
+			success = Sudoku::raise_step(vec, forced);
+
+			if (success && show)
+			{
+				if (Sudoku::len() <= 20)
+					accept();
+				std::cerr << *this << std::endl;
+			}
+		}
+
+		Sudoku::accept();
+		if (show)
+			std::cerr << *this << std::endl;
+	}
+
+	// statistics of the optimizer, summed over its runs
+	struct Stats
+	{
+		uint64_t runs{0};       // restarts
+		uint64_t found{0};      // runs that reached the target
+		uint64_t moves{0};      // moves tried
+		uint64_t accepted{0};   // moves accepted
+		int      best{INT_MIN}; // best weight seen
+	};
+
+	// simulated annealing over the clue moves: remove a clue, add one, move a clue to a linked cell or remove
+	// two clues and add one linked to them (the move of raise); the added value is any allowed one, a move
+	// leaving other than one solution is undone; the score is the exact weight, less 25 for every level
+	// below Expert; the temperature falls with the time from 25 (a clue) to zero; the run ends as soon as
+	// an Expert layout reaches the goal weight or when the time is up, the best layout is left then;
+	// the chance of the acceptance is drawn before the rating, so a move is rated up to the score it
+	// needs (the target) and only a move reaching it gets the complete rating
+	bool anneal( int goal, uint ms, Stats &stats )
+	{
+		using clock = std::chrono::steady_clock;
+		auto start = clock::now();
+		auto limit = std::chrono::milliseconds(ms);
+
+		stats.runs++;
+		Sudoku::accept(false, Difficulty::Medium);
+		if (Sudoku::rating < 0)
+			return false;
+
+		auto score = []( Sudoku &b ){ return b.weight() - (Difficulty::Expert - b.level) * 25; };
+		auto pick  = [this]( bool full, Cell *a, Cell *b ) -> Cell *
+		{
+			auto lst = std::vector<Cell *>();
+			for (Cell &c: *this)
+				if ((c.num != 0) == full && (a == nullptr || c.linked(a) || (b != nullptr && c.linked(b))))
+					lst.push_back(&c);
+			return lst.empty() ? nullptr : lst[Sudoku::rnd.below(static_cast<uint>(lst.size()))];
+		};
+
+		int  t = Sudoku::target;
+		Sudoku::target = INT_MIN;
+
+		auto best = *this;
+		int  cur  = score(*this);
+		int  top  = cur;
+		bool found = false;
+		for (auto now = clock::now(); !found && now - start < limit; now = clock::now())
+		{
+			double heat = 25.0 * (1.0 - std::chrono::duration<double>(now - start) / limit) + 0.01;
+			auto prev = *this;
+			stats.moves++;
+
+			uint  move = Sudoku::rnd.below(4);
+			Cell *ci = move != 1 ? pick(true, nullptr, nullptr) : nullptr;
+			if (ci != nullptr) ci->put(0);
+			Cell *cj = move == 3 ? pick(true, nullptr, nullptr) : nullptr;
+			if (cj != nullptr) cj->put(0);
+			Cell *ck = move != 0 ? pick(false, ci, cj) : nullptr;
+			auto  v  = std::vector<uint>();
+			if (ck != nullptr)
+				for (uint n: Cell::Values(*ck))
+					if (n != 0)
+						v.push_back(n);
+			if (v.size() > 0)
+				ck->put(v[Sudoku::rnd.below(static_cast<uint>(v.size()))]);
+
+			// a move that cannot be made in full is not tried
+			if ((move != 1 && ci == nullptr) || (move == 3 && cj == nullptr) || (move != 0 && v.empty()) ||
+			    Sudoku::count_solutions(2) != 1)
+			{
+				Sudoku::restore(prev);
+				continue;
+			}
+
+			// accepted: s >= cur or s > bar; the weight of an Expert layout needs at least the target
+			double u   = Sudoku::rnd.real();
+			double bar = u > 0 ? cur + heat * std::log(u) : -HUGE_VAL;
+			Sudoku::target = bar > INT_MIN / 2 ? std::min(cur, static_cast<int>(std::floor(bar)) + 1) : INT_MIN;
+			Sudoku::accept();
+			Sudoku::target = INT_MIN;
+
+			int s = Sudoku::weight(true);
+			if (s != INT_MAX)
+				s -= (Difficulty::Expert - Sudoku::level) * 25;
+			if (s < cur && s <= bar)
+			{
+				Sudoku::restore(prev);
+				continue;
+			}
+
+			if (Sudoku::truncated)
+				Sudoku::complete();
+			s = score(*this);
+			if (s >= cur || s > bar)
+			{
+				cur = s;
+				stats.accepted++;
+				if (cur > top)
+				{
+					top  = cur;
+					best = *this;
+				}
+				found = Sudoku::level >= Difficulty::Expert && Sudoku::weight() >= goal;
+			}
+			else
+				Sudoku::restore(prev);
+		}
+
+		if (!found)
+			Sudoku::restore(best);
+
+		Sudoku::target = t;
+		stats.best = std::max(stats.best, Sudoku::weight());
+		if (found)
+			stats.found++;
+		return found;
+	}
+
+	bool test( bool all )
+	{
+		if (Sudoku::rating == -2)
+		{
+			std::cerr << "ERROR: unsolvable" << std::endl;
+			return false;
+		}
+
+		if (Sudoku::rating == -1)
+		{
+			std::cerr << "ERROR: ambiguous"  << std::endl;
+			return false;
+		}
+
+		if (Sudoku::level == Difficulty::Easy || all || Sudoku::weight() >= 0)
+		{
+			if (Sudoku::truncated && Sudoku::budget.nodes == 0 && Sudoku::budget.ms == 0)
+				Sudoku::complete();
+			return true;
+		}
+
+		// the lower bound is not enough, the upper one could be
+		if (Sudoku::truncated && Sudoku::weight(true) >= 0)
+			std::cerr << "ERROR: rating truncated" << std::endl;
+
+		return false;
+	}
+
+	bool undo()
+	{
+		if (!Sudoku::mem.empty())
+		{
+			Sudoku::at(std::get<0>(Sudoku::mem.back())).put(std::get<1>(Sudoku::mem.back()));
+			Sudoku::mem.pop_back();
+			return false;
+		}
+		else
+		{
+			Sudoku::again();
+			Sudoku::specify_layout();
+			return true;
+		}
+	}
+
+private:
+
+	// the rating depends only on the filled cells, so it is parsed once for every partial layout;
+	// results are exact below the cap, any result reaching the cap is returned as the cap
+	int parse_rating( int cap = INT_MAX )
+	{
+		int result;
+		Memo &m = Sudoku::memo();
+		if (!m.find(Sudoku::key(), result))
+		{
+			result = Sudoku::parse_layout(1, cap);
+			if (result < cap)
+				m.store(Sudoku::key(), result);
+		}
+		return std::min(result, cap);
+	}
+
+	// with more than one job the branches of the first fork are rated in parallel;
+	// a cell whose sum reaches the least one found so far is not parsed any further
+	int parse_layout( uint threads = 1, int cap = INT_MAX )
+	{
+		std::vector<std::pair<Cell *, uint>> sure;
+		for (Cell &c: *this)
+		{
+			if (c.num == 0)
+			{
+				uint n = c.sure();
+				if (n != 0)
+					sure.emplace_back(&c, n);
+				else
+				if (c.len() < 2) // wrong way
+					return 0;
+			}
+		}
+
+		if (!sure.empty())
+		{
+			int  result  = 0;
+			bool success = true;
+			for (std::pair<Cell *, uint> &p: sure)
+				if (!std::get<Cell *>(p)->set(std::get<uint>(p)))
+					success = false;
+			if (success)
+				result = cap > 1 ? (threads > 1 ? Sudoku::parse_layout(threads, cap - 1) : Sudoku::parse_rating(cap - 1)) + 1 : 1;
+			for (std::pair<Cell *, uint> &p: sure)
+				std::get<Cell *>(p)->put(0);
+			return result;
+		}
+			
+		uint p = Sudoku::choose();
+		if (p == 81) // solved!
+			return 1;
+
+		Cell &cell = Sudoku::at(p);
+
+		uint len    = cell.len();
+		uint range  = cell.range();
+		if (cap <= 1)
+			return 1;
+		if (threads > 1)
+			return std::min(Sudoku::parse_fork(len, range, threads), cap - 1) + 1;
+
+		int result = 0;
+		for (Cell &c: *this)
+		{
+			if (c.num == 0 && c.len() == len && c.range() == range)
+			{
+				int r = 0;
+				int k = result == 0 ? cap - 1 : result;
+				for (uint v: Cell::Values(c))
+				{
+					if (r >= k)
+						break;
+					if (v != 0 && c.set(v))
+					{
+						r += Sudoku::parse_rating(k - r);
+						c.put(0);
+					}
+				}
+				if (result == 0 || r < result)
+					result = r;
+			}
+		}
+
+		return result + 1;
+	}
+
+	// the top of the search tree leads to the solution, so no cell there is a wrong way and the result
+	// is at most the sum of any of its cells; as soon as one of them is below the cap, the cap is
+	// unreachable: the parse stops and returns the upper bound, and the lower bound proved so far
+	// (one for every level above, the levels of the sure cells included) is set in place of zero
+	int parse_goal( int cap, int &lower )
+	{
+		std::vector<std::pair<Cell *, uint>> sure;
+		for (Cell &c: *this)
+		{
+			if (c.num == 0)
+			{
+				uint n = c.sure();
+				if (n != 0)
+					sure.emplace_back(&c, n);
+				else
+				if (c.len() < 2) // wrong way
+					return 0;
+			}
+		}
+
+		if (!sure.empty())
+		{
+			int  result  = 0;
+			bool success = true;
+			for (std::pair<Cell *, uint> &p: sure)
+				if (!std::get<Cell *>(p)->set(std::get<uint>(p)))
+					success = false;
+			if (success)
+				result = cap > 1 ? Sudoku::parse_goal(cap - 1, lower) + 1 : 1;
+			if (lower > 0)
+				lower++;
+			for (std::pair<Cell *, uint> &p: sure)
+				std::get<Cell *>(p)->put(0);
+			return result;
+		}
+
+		uint p = Sudoku::choose();
+		if (p == 81) // solved!
+			return 1;
+
+		Cell &cell = Sudoku::at(p);
+
+		uint len    = cell.len();
+		uint range  = cell.range();
+		if (cap <= 1)
+			return 1;
+
+		int result = 0;
+		for (Cell &c: *this)
+		{
+			if (c.num == 0 && c.len() == len && c.range() == range)
+			{
+				int r = 0;
+				int k = result == 0 ? cap - 1 : result;
+				for (uint v: Cell::Values(c))
+				{
+					if (r >= k)
+						break;
+					if (v != 0 && c.set(v))
+					{
+						r += Sudoku::parse_rating(k - r);
+						c.put(0);
+					}
+				}
+				if (result == 0 || r < result)
+					result = r;
+				if (result < cap - 1)
+				{
+					lower = 1;
+					break;
+				}
+			}
+		}
+
+		return result + 1;
+	}
+
+	// every branch (cell, value) of the first fork is a task rated on its own copy of the board;
+	// the tasks are taken by the workers as they get free and the ratings
+	// are combined in the serial order, so the result is the same
+	int parse_fork( uint len, uint range, uint threads )
+	{
+		struct Task
+		{
+			uint cell;
+			uint pos;
+			uint value;
+			int  rating;
+		};
+
+		std::vector<Task> task;
+		uint cells = 0;
+		for (Cell &c: *this)
+		{
+			if (c.num == 0 && c.len() == len && c.range() == range)
+			{
+				for (uint v: Cell::Values(c))
+					if (v != 0)
+						task.push_back(Task{cells, c.pos, v, 0});
+				cells++;
+			}
+		}
+
+		std::atomic<size_t> next{0};
+		auto work = [this, &task, &next]
+		{
+			for (size_t i = next++; i < task.size(); i = next++)
+			{
+				Sudoku tmp = *this;
+				if (tmp.at(task[i].pos).set(task[i].value))
+					task[i].rating = tmp.parse_rating();
+			}
+		};
+
+		Sudoku::workers().run(static_cast<uint>(std::min<size_t>(threads, task.size())), work);
+
+		auto r = std::vector<int>(cells, 0);
+		for (Task &t: task)
+			r[t.cell] += t.rating;
+
+		int result = 0;
+		for (int x: r)
+			if (result == 0 || x < result)
+				result = x;
+
+		return result;
+	}
+
+	// the rating grows with the size of the search tree
+	int scale_rating( int result )
+	{
+		int msb = 0;
+		int r   = 0;
+		for (uint i = Sudoku::count(0); result > 0; r += static_cast<int>(i--), result >>= 1)
+			msb = (result & 1) ? msb + 1 : 0;
+		return r + msb - 1;
+	}
+
+	// possible results of a parse cut by the budget: zero (a wrong way) and / or any value from lo to hi
+	struct Range
+	{
+		bool zero;
+		int  lo;
+		int  hi;   // INT_MAX: unknown
+
+		static Range exact( int v ) { return v == 0 ? Range{true, INT_MAX, 0} : Range{false, v, v}; }
+		static Range unknown()      { return Range{true, 1, INT_MAX}; }
+
+		bool empty() const { return lo > hi; }
+		bool known() const { return  zero ? empty() : lo == hi; }
+
+		void join( int l, int h )
+		{
+			Range::lo = std::min(Range::lo, l);
+			Range::hi = std::max(Range::hi, h);
+		}
+
+		static int sum( int a, int b ) { return a > INT_MAX - b ? INT_MAX : a + b; }
+
+		// a + b
+		friend Range operator+( const Range &a, const Range &b )
+		{
+			Range r{a.zero && b.zero, INT_MAX, 0};
+			if (a.zero && !b.empty()) r.join(b.lo, b.hi);
+			if (b.zero && !a.empty()) r.join(a.lo, a.hi);
+			if (!a.empty() && !b.empty()) r.join(Range::sum(a.lo, b.lo), Range::sum(a.hi, b.hi));
+			return r;
+		}
+
+		// a + 1
+		Range next() const
+		{
+			Range r{false, INT_MAX, 0};
+			if (Range::zero) r.join(1, 1);
+			if (!Range::empty()) r.join(Range::sum(Range::lo, 1), Range::sum(Range::hi, 1));
+			return r;
+		}
+
+		// (a == 0 || b < a) ? b : a
+		Range least( const Range &b ) const
+		{
+			Range r{false, INT_MAX, 0};
+			if (Range::zero) { r.zero = b.zero; if (!b.empty()) r.join(b.lo, b.hi); }
+			if (!Range::empty()) { r.zero = r.zero || b.zero; if (!b.empty()) r.join(std::min(Range::lo, b.lo), std::min(Range::hi, b.hi)); }
+			return r;
+		}
+	};
+
+	// nodes and time left for the rating
+	struct Meter
+	{
+		uint64_t nodes;
+		bool     timed;
+		bool     out{false};
+		std::chrono::steady_clock::time_point deadline;
+
+		Meter( const Budget &b ):
+			nodes{b.nodes ? b.nodes : UINT64_MAX},
+			timed{b.ms != 0},
+			deadline{std::chrono::steady_clock::now() + std::chrono::milliseconds(b.ms)} {}
+
+		bool spend()
+		{
+			if (!Meter::out && (Meter::nodes-- == 0 || (Meter::timed && (Meter::nodes & 0xFF) == 0 && std::chrono::steady_clock::now() >= Meter::deadline)))
+				Meter::out = true;
+			return !Meter::out;
+		}
+	};
+
+	// parse_layout within the budget; the unparsed subtrees make the result a range,
+	// only the exact results are memoized
+	Range parse_range( Meter &m )
+	{
+		int result;
+		Memo &memo = Sudoku::memo();
+		if (memo.find(Sudoku::key(), result))
+			return Range::exact(result);
+
+		if (!m.spend())
+			return Range::unknown();
+
+		Range range = Sudoku::parse_bounded(m);
+		if (range.known())
+			memo.store(Sudoku::key(), range.zero ? 0 : range.lo);
+		return range;
+	}
+
+	Range parse_bounded( Meter &m )
+	{
+		std::vector<std::pair<Cell *, uint>> sure;
+		for (Cell &c: *this)
+		{
+			if (c.num == 0)
+			{
+				uint n = c.sure();
+				if (n != 0)
+					sure.emplace_back(&c, n);
+				else
+				if (c.len() < 2) // wrong way
+					return Range::exact(0);
+			}
+		}
+
+		if (!sure.empty())
+		{
+			Range result  = Range::exact(0);
+			bool  success = true;
+			for (std::pair<Cell *, uint> &p: sure)
+				if (!std::get<Cell *>(p)->set(std::get<uint>(p)))
+					success = false;
+			if (success)
+				result = Sudoku::parse_range(m).next();
+			for (std::pair<Cell *, uint> &p: sure)
+				std::get<Cell *>(p)->put(0);
+			return result;
+		}
+
+		uint p = Sudoku::choose();
+		if (p == 81) // solved!
+			return Range::exact(1);
+
+		Cell &cell = Sudoku::at(p);
+
+		uint len    = cell.len();
+		uint range  = cell.range();
+
+		Range result = Range::exact(0);
+		for (Cell &c: *this)
+		{
+			if (c.num == 0 && c.len() == len && c.range() == range)
+			{
+				Range r = Range::exact(0);
+				for (uint v: Cell::Values(c))
+				{
+					if (v != 0 && c.set(v))
+					{
+						r = r + Sudoku::parse_range(m);
+						c.put(0);
+					}
+				}
+				result = result.least(r);
+			}
+		}
+
+		return result.next();
+	}
+
+	// the least result of parse_layout whose rating reaches the target weight
+	int threshold()
+	{
+		if (Sudoku::target == INT_MIN)
+			return INT_MAX;
+
+		int goal = Sudoku::target + static_cast<int>(Sudoku::len()) * 25;
+		if (Sudoku::scale_rating(INT_MAX) < goal)
+			return INT_MAX;
+
+		int lo = 1, hi = INT_MAX;
+		while (lo < hi)
+		{
+			int mid = lo + (hi - lo) / 2;
+			if (Sudoku::scale_rating(mid) < goal)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		return lo;
+	}
+
+	// full rating of a board truncated at the target
+	void complete()
+	{
+		int t = Sudoku::target;
+		Sudoku::target = INT_MIN;
+		Sudoku::calculate_rating();
+		Sudoku::target = t;
+	}
+
+	void calculate_rating( bool estimate = false )
+	{
+		Sudoku::truncated = false;
+		Sudoku::upper = Sudoku::rating = Sudoku::solvable(); if (Sudoku::rating != 0) return;
+		Sudoku::upper = Sudoku::rating = Sudoku::correct();  if (Sudoku::rating != 0) return;
+
+		if (estimate || Sudoku::level == Difficulty::Extreme) return;
+
+		if (Sudoku::grader == Grader::Logic)
+		{
+			Sudoku::upper = Sudoku::rating = Sudoku::grade().rating();
+			return;
+		}
+
+		if (Sudoku::budget.nodes != 0 || Sudoku::budget.ms != 0)
+		{
+			Meter m{Sudoku::budget};
+			Range r = Sudoku::parse_range(m);
+			Sudoku::truncated = m.out;
+			Sudoku::rating = Sudoku::scale_rating(r.zero || r.empty() ? 0 : r.lo);
+			Sudoku::upper  = r.empty() ? Sudoku::scale_rating(0) : r.hi == INT_MAX ? INT_MAX : Sudoku::scale_rating(r.hi);
+			return;
+		}
+
+		int cap = Sudoku::threshold();
+		if (cap < INT_MAX)
+		{
+			int lower = 0;
+			int result = Sudoku::parse_goal(cap, lower);
+			Sudoku::truncated = lower > 0 || result >= cap;
+			Sudoku::rating = Sudoku::scale_rating(lower > 0 ? lower : result);
+			Sudoku::upper  = lower > 0 || result < cap ? Sudoku::scale_rating(result) : INT_MAX;
+			return;
+		}
+
+		int result = Sudoku::jobs > 1 ? Sudoku::parse_layout(Sudoku::jobs) : Sudoku::parse_rating();
+		Sudoku::upper = Sudoku::rating = Sudoku::scale_rating(result);
+	//	Sudoku::rating = Sudoku::parse_rating();
+	}
+
+	void calculate_level()
+	{
+		if ( Sudoku::level                      == Difficulty::Easy)    { return; }
+		if ( Sudoku::level                      == Difficulty::Extreme) { return; }
+		if ( Sudoku::rating < 0) { Sudoku::level = Difficulty::Medium;    return; }
+		if ( Sudoku::solved())   { Sudoku::level = Difficulty::Medium;    return; }
+		if (!Sudoku::simplify()) { Sudoku::level = Difficulty::Expert;    return; }
+		if (!Sudoku::solved())   { Sudoku::level = Difficulty::Hard;              }
+		else                     { Sudoku::level = Difficulty::Medium;            }
+		Sudoku::again();
+	}
+
+	// the layout invariants behind the signature: sorted counts of digits, lengths and ranges of cells
+	std::array<uint32_t, 10 + 81 + 81> invariants()
+	{
+		std::array<uint32_t, 10 + 81 + 81> result{};
+		auto v = result.begin();
+		auto l = v + 10;
+		auto r = l + 81;
+
+		for (Cell &c: *this)
+		{
+			v[c.num]++;
+			l[c.pos] = static_cast<uint32_t>(c.len());
+			r[c.pos] = static_cast<uint32_t>(c.range());
+		}
+
+		std::sort(v, l);
+		std::sort(l, r);
+		std::sort(r, result.end());
+
+		return result;
+	}
+
+	void calculate_signature( bool estimate = false )
+	{
+		if (estimate)
+		{
+			Sudoku::signature = 0;
+			Sudoku::digest = 0;
+			return;
+		}
+
+		auto data = Sudoku::invariants();
+		Sudoku::signature = Sudoku::castagnoli ? SudokuHash::crc32c(data.data(), sizeof(data)) : SudokuHash::crc32(data.data(), sizeof(data));
+		Sudoku::calculate_digest();
+	}
+
+	// the givens themselves, seeded with the signature: the isomorphs are told apart
+	void calculate_digest()
+	{
+		std::array<uint8_t, 81> num;
+		for (Cell &c: *this)
+			num[c.pos] = static_cast<uint8_t>(c.immutable ? c.num : 0);
+
+		auto data = SudokuHash::pack(num);
+		Sudoku::digest = SudokuHash::hash64(data.data(), data.size(), Sudoku::signature);
+	}
+
+	void specify_layout( bool estimate = false )
+	{
+		Sudoku::calculate_rating(estimate);
+		Sudoku::calculate_level();		// must be after calculate_rating (depends on the rating)
+		Sudoku::calculate_signature(estimate);
+	}
+
+public:
+
+	static
+	bool by_weight( Sudoku &a, Sudoku &b )
+	{
+		int a_wgt = a.weight();
+		int b_wgt = b.weight();
+		uint a_len = a.len();
+		uint b_len = b.len();
+
+		return a_wgt  > b_wgt ||
+		      (a_wgt == b_wgt && (a_len  < b_len ||
+		                         (a_len == b_len && (a.level  > b.level ||
+		                                            (a.level == b.level && a.signature < b.signature)))));
+	}
+
+	static
+	bool by_rating( Sudoku &a, Sudoku &b )
+	{
+		uint a_len = a.len();
+		uint b_len = b.len();
+
+		return a.rating  > b.rating ||
+		      (a.rating == b.rating && (a_len  < b_len ||
+		                               (a_len == b_len && (a.level  > b.level ||
+		                                                  (a.level == b.level && a.signature < b.signature)))));
+	}
+
+	static
+	bool by_length( Sudoku &a, Sudoku &b )
+	{
+		uint a_len = a.len();
+		uint b_len = b.len();
+
+		return a_len  < b_len ||
+		      (a_len == b_len && (a.rating  > b.rating ||
+		                         (a.rating == b.rating && (a.level  > b.level ||
+		                                                  (a.level == b.level && a.signature < b.signature)))));
+	}
+
+	template<class T> friend
+	std::basic_istream<T> &operator >>( std::basic_istream<T> &in, Sudoku &sudoku )
+	{
+		std::basic_string<T> line;
+		if (std::getline(in, line))
+		{
+			sudoku.level = Difficulty::Medium;
+			if (line.size() > 0)
+				sudoku.init(line.substr(0, 81));
+		}
+
+		return in;
+	}
+
+	template<class T> friend
+	std::basic_ostream<T> &operator <<( std::basic_ostream<T> &out, Sudoku &sudoku )
+	{
+		for (Cell &c: sudoku)
+			out << c;
+		out << '|'          <<             sudoku.level     << ':'
+		    << std::setw(2) <<             sudoku.len()     << ':'
+		    << std::setw(3) <<             sudoku.rating    << ':'
+		    << std::setw(8) << std::hex << sudoku.signature << std::dec;
+		return out;
+	}
+
+	bool load( const TCHAR *filename = _T("sudoku.board") )
+	{
+		auto file = std::basic_ifstream<TCHAR>(filename);
+		if (!file.is_open())
+			return false;
+
+		Sudoku::Backup tmp(this);
+
+		file >> *this;
+
+		file.close();
+
+		return tmp.changed();
+	}
+
+	void save( const TCHAR *filename = _T("sudoku.board") )
+	{
+		auto file = std::basic_ofstream<TCHAR>(filename, std::ios::out);
+		if (!file.is_open())
+			return;
+
+		file << *this << std::endl;
+
+		file.close();
+
+		auto htmlname = std::basic_string<TCHAR>(filename) + _T(".html");
+		file = std::basic_ofstream<TCHAR>(htmlname.c_str(), std::ios::out);
+		if (!file.is_open())
+			return;
+
+		size_t pos = 0;
+		auto puzzle = html;
+		for (Cell &c: *this)
+		{
+			pos = puzzle.find(_T(" </td>"), pos + 1);
+			puzzle[pos] = _T(" 123456789")[c.num];
+		}
+		
+		file << puzzle;
+
+		file.close();
+	}
+
+	void append( const TCHAR *filename )
+	{
+		auto file = std::basic_ofstream<TCHAR>(filename, std::ios::app);
+		if (!file.is_open())
+			return;
+
+		file << *this << std::endl;
+
+		file.close();
+	}
+
+	static
+	void load( std::vector<std::basic_string<TCHAR>> &lst, const TCHAR *filename )
+	{
+		auto file = std::basic_ifstream<TCHAR>(filename);
+		if (!file.is_open())
+			return;
+
+		std::basic_string<TCHAR> line;
+		while (std::getline(file, line))
+		{
+			if (line.size() > 0)
+				lst.push_back(line.substr(0, 81));
+		}
+
+		file.close();
+	}
+};
+
+inline
+bool Sudoku::castagnoli = false;
+
+inline
+std::basic_string<TCHAR> Sudoku::pool_file = _T("sudoku.pool");
+
+inline const
+std::vector<std::basic_string<TCHAR>> Sudoku::extreme =
+{
+_T(".2.4.37.........32........4.4.2...7.8...5.........1...5.....9...3.9....7..1..86..|3:21:702:9c071975"),
+_T("4.....8.5.3..........7......2.....6.....8.4...4..1.......6.3.7.5.32.1...1.4......|3:20:666:10144aa6"),
+_T("52...6.........7.131..........4..8..6......5...........418.........3..28.387.....|3:20:666:f54090de"),
+_T(".9............15...68........2.5.4.....8...9...1....5..2.6...85....75...4.....96.|3:21:654:ae498c1b"),
+_T("12....3.8.6.4..............2.3.1...........758.7......97.5...6..31.8.2...........|3:21:654:ea3fbd5f"),
+_T("7.48..............328...16....2....15.......8....93........6.....63..5...351.2...|3:22:642:16cb5f8e"),
+_T("52.....8...........1....7.575694......467...............8.1..29.6...24.......9..8|3:23:630:346fd02a"),
+_T("6.....8.3.4.7.................5.4.7.3.42.1...1.6.......2.....5.....8.6...6..1....|3:20:617:d9865cd1"),
+_T("2.....31..9.3.......35.64..721.........1.3.7....7.4....18.....5....3.6..........8|3:23:584:c05d7af0"),
+_T("...2.8.1..4.3.18............94.2...56.7.5..8.1........7.6...35......7..44........|3:23:584:e8d23d52"),
+_T("..7.........9....384..1..2..7....2..36....7.......7.8.......94.18..4...2.....216.|3:23:583:027907b4"),
+_T("4.....3.8...8.2...8..7.....2..1...8734.......6........5.4.6.8......184...82......|3:23:583:2ab93c5f"),
+_T(".56....82..........28...1.6....56.....5..13....14.........1...8.....2..7.7.59.4..|3:23:583:2e45ac45"),
+_T(".9............15...68........2.5.4...5.8...9........5....649185...1.....4.....967|3:23:583:f6415629"),
+_T("48.3............7112.......7.5....6....2..8.............1.76...3.....4......53...|3:19:576:0f8412ed"),
+_T(".923.........8.1...........1.7.4...........658.6.......6.5.2...4.....7.....9.4...|3:19:575:abdc6334"),
+_T(".68.......52..7..........845..3...9..7...5...1..............5.78........3..4..2.8|3:20:567:d8cd3478"),
+_T("458....3....8.1....9.....8.....5.39.2..7......4........1..48.........7.2...6.....|3:20:565:ed9dbd09"),
+_T("4.....8.5.3........5.7......2.....6.....5.4......1.......693.71..32.1...1.9......|3:21:560:ad7de212"),
+_T(".......39.....1..5..3.5.8....8.9...6.7...2...1..4.......9.8..5..2....6..4..7.....|3:21:556:33afc54f"),
+_T("8..........36......7..9.2...5...7.......457.....1...3...1....68..85...1..9....4..|3:21:555:078b18c4"),
+_T(".1..6..9...795.......32..4.....42.3...9...8.............8..6..1.2..3.7..4........|3:21:555:0bc328c9"),
+_T("..1..4.......6.3.5...9.....8.....7.3.......285...7.6..3...8...6..92......4...1...|3:21:555:2fde6b62"),
+_T("6....5....9....4.87..2............1..1....764....1.8.9.....2....4.6.....38.5.....|3:21:555:495d82fa"),
+_T("1.......2.9.4...5...6...7...5.9.3.......7.......85..4.7.....6...3...9.8...2.....1|3:21:555:f8bffe1a"),
+_T("....14....3....2...7..........9...3.6.1.............8.2.....1.4....5.6.8...7.8...|3:18:533:102bebdc"),
+_T("3...8.......7....51.......3......36...2..4....7...........6.13..452...........85.|3:19:522:88f2a7a1"),
+_T("......5..........39..64......8.7......3.....2....6..4.67.....9......58..48...6...|3:19:522:95d90963"),
+_T("...5.1....9....8...6.......4.1..........7..9........3.8.....1.5...21.4.3.1.36....|3:20:518:21d22039"),
+_T(".7...15..63..4...........8......7.3...5....4......96.....8..9..2...6...1....5...8|3:20:513:0a6a7338"),
+_T("49.....7..8..6..2......5..3.2.....4...8..2........1...3...7.1....1...3.5.6.......|3:20:513:399a75f8"),
+_T(".26.........6....3.74.8.........3..2.8..4..1.6..5.........1.78.5....9..........4.|3:20:513:5ff0c9e4"),
+_T(".98.1....2......6.............3.2.5..84.........6.4.......4.8.93..5.....8.....1.5|3:20:513:ebd7fdce"),
+};
+
+inline const
+std::basic_string<TCHAR> Sudoku::html =
+_T("<!doctype html><html><head><title>sudoku</title><style>table{margin-left:auto;margin-right:auto;font-family:Tahoma,Verdana,sans-serif;font-weight:bold;}table,td{border:1px solid black;border-collapse:collapse;}td{width:80px;height:80px;font-size:64px;text-align:center;vertical-align:middle}#top-left{border-top-width:5px;border-left-width:5px;}#top{border-top-width:5px;}#top-right{border-top-width:5px;border-right-width:5px;}#left{border-left-width:5px;}#center{}#right{border-right-width:5px;}#bottom-left{border-bottom-width:5px;border-left-width:5px;}#bottom{border-bottom-width:5px;}#bottom-right{border-bottom-width:5px;border-right-width:5px;}</style></head><body><table><caption><h1>SUDOKU</h1></caption><tr><td id=top-left> </td><td id=top> </td><td id=top-right> </td><td id=top-left> </td><td id=top> </td><td id=top-right> </td><td id=top-left> </td><td id=top> </td><td id=top-right> </td></tr><tr><td id=left> </td><td id=center> </td><td id=right> </td><td id=left> </td><td id=center> </td><td id=right> </td><td id=left> </td><td id=center> </td><td id=right> </td></tr><tr><td id=bottom-left> </td><td id=bottom> </td><td id=bottom-right> </td><td id=bottom-left> </td><td id=bottom> </td><td id=bottom-right> </td><td id=bottom-left> </td><td id=bottom> </td><td id=bottom-right> </td></tr><tr><td id=top-left> </td><td id=top> </td><td id=top-right> </td><td id=top-left> </td><td id=top> </td><td id=top-right> </td><td id=top-left> </td><td id=top> </td><td id=top-right> </td></tr><tr><td id=left> </td><td id=center> </td><td id=right> </td><td id=left> </td><td id=center> </td><td id=right> </td><td id=left> </td><td id=center> </td><td id=right> </td></tr><tr><td id=bottom-left> </td><td id=bottom> </td><td id=bottom-right> </td><td id=bottom-left> </td><td id=bottom> </td><td id=bottom-right> </td><td id=bottom-left> </td><td id=bottom> </td><td id=bottom-right> </td></tr><tr><td id=top-left> </td><td id=top> </td><td id=top-right> </td><td id=top-left> </td><td id=top> </td><td id=top-right> </td><td id=top-left> </td><td id=top> </td><td id=top-right> </td></tr><tr><td id=left> </td><td id=center> </td><td id=right> </td><td id=left> </td><td id=center> </td><td id=right> </td><td id=left> </td><td id=center> </td><td id=right> </td></tr><tr><td id=bottom-left> </td><td id=bottom> </td><td id=bottom-right> </td><td id=bottom-left> </td><td id=bottom> </td><td id=bottom-right> </td><td id=bottom-left> </td><td id=bottom> </td><td id=bottom-right> </td></tr></table></body></html>");
+
+// set of boards already seen by a batch mode, keyed by the signature, the wide signature
+// or the canonical form (then every isomorph of a board is a duplicate)
+// open addressing with linear probing, 0 marks an empty slot (key 0 is kept apart)
+class SudokuIndex
+{
+	std::vector<uint64_t> tab;
+	size_t cnt;
+	bool   nil;
+	uint   shift;
+	Dedup  mode;
+
+	static
+	SudokuMinlex &minlex()
+	{
+		static thread_local SudokuMinlex minlex{};
+		return minlex;
+	}
+
+	size_t slot( uint64_t key ) const
+	{
+		return static_cast<size_t>((key * UINT64_C(0x9E3779B97F4A7C15)) >> SudokuIndex::shift);
+	}
+
+	size_t find( uint64_t key ) const
+	{
+		size_t msk = SudokuIndex::tab.size() - 1;
+		size_t pos = SudokuIndex::slot(key);
+		while (SudokuIndex::tab[pos] != 0 && SudokuIndex::tab[pos] != key)
+			pos = (pos + 1) & msk;
+		return pos;
+	}
+
+	void grow()
+	{
+		auto old = std::vector<uint64_t>(SudokuIndex::tab.size() * 2, 0);
+		std::swap(old, SudokuIndex::tab);
+		SudokuIndex::shift--;
+		for (uint64_t key: old)
+			if (key != 0)
+				SudokuIndex::tab[SudokuIndex::find(key)] = key;
+	}
+
+	// signature recorded at the end of the line: "board|level:length:rating:signature"
+	static
+	bool parse( const std::basic_string<TCHAR> &line, uint32_t &sig )
+	{
+		auto pos = line.rfind(_T(':'));
+		if (line.find(_T('|')) != 81 || pos == line.npos || pos + 1 == line.size())
+			return false;
+
+		sig = 0;
+		while (pos + 2 < line.size() && line[pos + 1] == _T(' ')) // the signature is written with setw(8)
+			pos++;
+		for (auto i = pos + 1; i < line.size(); i++)
+		{
+			TCHAR c = line[i];
+			uint  x = c >= _T('0') && c <= _T('9') ? static_cast<uint>(c - _T('0'))      :
+			          c >= _T('a') && c <= _T('f') ? static_cast<uint>(c - _T('a')) + 10 :
+			          c >= _T('A') && c <= _T('F') ? static_cast<uint>(c - _T('A')) + 10 : 16;
+			if (x > 15 || i - pos > 8)
+				return false;
+			sig = (sig << 4) | x;
+		}
+
+		return true;
+	}
+
+public:
+
+	SudokuIndex( Dedup _m = Dedup::Signature ): tab(1024, 0), cnt{0}, nil{false}, shift{64 - 10}, mode{_m} {}
+
+	size_t size() const { return SudokuIndex::cnt; }
+
+	// the givens only: entered digits do not count
+	uint64_t key( Sudoku &sudoku ) const
+	{
+		if (SudokuIndex::mode == Dedup::Signature)
+			return sudoku.signature;
+		if (SudokuIndex::mode == Dedup::Digest)
+			return sudoku.digest;
+
+		SudokuMinlex::Grid g;
+		for (SudokuCell &c: sudoku)
+			g[c.pos] = static_cast<uint8_t>(c.immutable ? c.num : 0);
+		return SudokuMinlex::key(SudokuIndex::minlex().canon(g));
+	}
+
+	bool contains( uint64_t key ) const
+	{
+		return key == 0 ? SudokuIndex::nil : SudokuIndex::tab[SudokuIndex::find(key)] != 0;
+	}
+
+	bool contains( Sudoku &sudoku ) const
+	{
+		return SudokuIndex::contains(SudokuIndex::key(sudoku));
+	}
+
+	// false if the key was already there
+	bool insert( uint64_t key )
+	{
+		if (key == 0)
+		{
+			if (SudokuIndex::nil)
+				return false;
+			SudokuIndex::nil = true;
+			SudokuIndex::cnt++;
+			return true;
+		}
+
+		size_t pos = SudokuIndex::find(key);
+		if (SudokuIndex::tab[pos] != 0)
+			return false;
+
+		SudokuIndex::tab[pos] = key;
+		if (++SudokuIndex::cnt * 2 > SudokuIndex::tab.size())
+			SudokuIndex::grow();
+		return true;
+	}
+
+	bool insert( Sudoku &sudoku )
+	{
+		return SudokuIndex::insert(SudokuIndex::key(sudoku));
+	}
+
+	// preload the keys of the boards stored in the file; only the lines
+	// with no recorded signature are rated
+	void load( const TCHAR *filename )
+	{
+		auto file = std::basic_ifstream<TCHAR>(filename);
+		if (!file.is_open())
+			return;
+
+		auto sudoku = Sudoku(Difficulty::Medium);
+		std::basic_string<TCHAR> line;
+		while (std::getline(file, line))
+		{
+			uint32_t sig;
+			if (line.size() > 0 && line.back() == _T('\r'))
+				line.pop_back();
+			if (line.size() == 0)
+				continue;
+			SudokuMinlex::Grid g;
+			for (uint i = 0; i < 81; i++)
+				g[i] = static_cast<uint8_t>(i < line.size() && line[i] >= _T('1') && line[i] <= _T('9') ? line[i] - _T('0') : 0);
+			if (SudokuIndex::mode == Dedup::Canonical)
+			{
+				SudokuIndex::insert(SudokuMinlex::key(SudokuIndex::minlex().canon(g)));
+				continue;
+			}
+			if (!SudokuIndex::parse(line, sig))
+			{
+				sudoku.init(line.substr(0, 81));
+				SudokuIndex::insert(sudoku);
+				continue;
+			}
+			if (SudokuIndex::mode == Dedup::Digest)
+			{
+				// the same key as Sudoku::calculate_digest, from the recorded signature
+				auto data = SudokuHash::pack(g);
+				SudokuIndex::insert(SudokuHash::hash64(data.data(), data.size(), sig));
+				continue;
+			}
+			SudokuIndex::insert(sig);
+		}
+
+		file.close();
+	}
+};
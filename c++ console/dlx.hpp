@@ -0,0 +1,206 @@
+/******************************************************************************
+
+   @file    dlx.hpp
+   @author  Rajmund Szymanski
+   @date    29.12.2020
+   @brief   exact cover solver (Algorithm X with dancing links)
+
+*******************************************************************************
+
+   Copyright (c) 2018 - 2020 Rajmund Szymanski. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+
+******************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Sudoku as an exact cover problem: 729 rows (cell, digit) and 324 columns
+// (cell filled, digit in row, digit in column, digit in segment)
+
+class SudokuDLX
+{
+	using uint = unsigned int;
+
+	static constexpr uint COLS = 324;
+	static constexpr uint ROWS = 729;
+	static constexpr uint SIZE = 1 + COLS + ROWS * 4; // root, column headers, nodes
+
+	std::array<uint16_t, SIZE> L, R, U, D, C;
+	std::array<uint16_t, SIZE> row;
+	std::array<uint16_t, COLS + 1> S;
+	std::array<bool, COLS + 1> covered;
+
+	std::array<uint16_t, 81> stack;
+	std::array<uint8_t, 81>  grid;
+	uint depth;
+	uint found;
+	uint limit;
+
+	void cover( uint c )
+	{
+		covered[c] = true;
+		L[R[c]] = L[c];
+		R[L[c]] = R[c];
+		for (uint i = D[c]; i != c; i = D[i])
+			for (uint j = R[i]; j != i; j = R[j])
+			{
+				U[D[j]] = U[j];
+				D[U[j]] = D[j];
+				S[C[j]]--;
+			}
+	}
+
+	void uncover( uint c )
+	{
+		for (uint i = U[c]; i != c; i = U[i])
+			for (uint j = L[i]; j != i; j = L[j])
+			{
+				S[C[j]]++;
+				U[D[j]] = j;
+				D[U[j]] = j;
+			}
+		L[R[c]] = c;
+		R[L[c]] = c;
+		covered[c] = false;
+	}
+
+	void search()
+	{
+		if (R[0] == 0)
+		{
+			if (found++ == 0)
+				for (uint i = 0; i < depth; i++)
+					grid[stack[i] / 9] = static_cast<uint8_t>(stack[i] % 9 + 1);
+			return;
+		}
+
+		uint c = R[0];
+		for (uint j = R[c]; j != 0; j = R[j])
+			if (S[j] < S[c])
+				c = j;
+
+		if (S[c] == 0)
+			return;
+
+		cover(c);
+		for (uint r = D[c]; r != c && found < limit; r = D[r])
+		{
+			stack[depth++] = row[r];
+			for (uint j = R[r]; j != r; j = R[j]) cover(C[j]);
+			search();
+			for (uint j = L[r]; j != r; j = L[j]) uncover(C[j]);
+			depth--;
+		}
+		uncover(c);
+	}
+
+	// select the row of a given digit; false if it conflicts with the rows selected before
+	bool select( uint r )
+	{
+		uint n = 1 + COLS + r * 4;
+		for (uint j = n; j < n + 4; j++)
+			if (covered[C[j]])
+				return false;
+
+		for (uint j = n; j < n + 4; j++)
+			cover(C[j]);
+
+		stack[depth++] = static_cast<uint16_t>(r);
+		return true;
+	}
+
+	void release()
+	{
+		while (depth > 0)
+		{
+			uint n = 1 + COLS + stack[--depth] * 4u;
+			for (uint j = n + 4; j-- > n; )
+				uncover(C[j]);
+		}
+	}
+
+public:
+
+	SudokuDLX(): depth{0}, found{0}, limit{0}
+	{
+		for (uint c = 0; c <= COLS; c++)
+		{
+			L[c] = static_cast<uint16_t>(c == 0 ? COLS : c - 1);
+			R[c] = static_cast<uint16_t>(c == COLS ? 0 : c + 1);
+			U[c] = D[c] = C[c] = static_cast<uint16_t>(c);
+			row[c] = 0;
+			S[c] = 0;
+			covered[c] = false;
+		}
+
+		for (uint r = 0; r < ROWS; r++)
+		{
+			uint p = r / 9, n = r % 9;
+			uint x = p % 9, y = p / 9, s = (y / 3) * 3 + x / 3;
+			uint cols[4] = { 1 + p, 1 + 81 + y * 9 + n, 1 + 162 + x * 9 + n, 1 + 243 + s * 9 + n };
+
+			uint first_node = 1 + COLS + r * 4;
+			for (uint k = 0; k < 4; k++)
+			{
+				uint i = first_node + k;
+				uint c = cols[k];
+				C[i] = static_cast<uint16_t>(c);
+				row[i] = static_cast<uint16_t>(r);
+				L[i] = static_cast<uint16_t>(first_node + (k + 3) % 4);
+				R[i] = static_cast<uint16_t>(first_node + (k + 1) % 4);
+				U[i] = U[c];
+				D[i] = static_cast<uint16_t>(c);
+				D[U[c]] = static_cast<uint16_t>(i);
+				U[c] = static_cast<uint16_t>(i);
+				S[c]++;
+			}
+		}
+	}
+
+	// number of solutions of the layout (counting stops at the limit)
+	// T is any 81-element table of cells with the 'num' member
+	template<class T>
+	uint solve( const T &tab, uint max = 1 )
+	{
+		SudokuDLX::depth = 0;
+		SudokuDLX::found = 0;
+		SudokuDLX::limit = max;
+
+		bool success = true;
+		for (uint p = 0; success && p < 81; p++)
+			if (tab[p].num != 0)
+				success = SudokuDLX::select(p * 9 + tab[p].num - 1);
+
+		if (success)
+			SudokuDLX::search();
+
+		SudokuDLX::release();
+		return SudokuDLX::found;
+	}
+
+	// digit of the cell in the first solution found by the last call of solve()
+	uint get( uint p ) const
+	{
+		return SudokuDLX::grid[p];
+	}
+};
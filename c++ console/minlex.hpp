@@ -0,0 +1,250 @@
+/******************************************************************************
+
+   @file    minlex.hpp
+   @author  Rajmund Szymanski
+   @date    29.12.2020
+   @brief   canonical form of a layout (minimal lexicographic isomorph)
+
+*******************************************************************************
+
+   Copyright (c) 2018 - 2020 Rajmund Szymanski. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+
+******************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include "hash.hpp"
+
+// Two layouts are the same puzzle if one is a transformation of the other:
+// transposition, permutation of bands, of rows within a band, of stacks,
+// of columns within a stack and relabeling of digits. The canonical form is
+// the smallest (empty cell = 0) of all the transformed layouts with digits
+// labeled in order of their first appearance.
+// The layout is built row by row; after each row only the partial
+// transformations giving the smallest prefix survive. The first row fixes
+// the columns (the minimal first row depends only on the number of givens
+// in each stack), so every later row just picks the best row from the band.
+
+class SudokuMinlex
+{
+	using uint = unsigned int;
+
+public:
+
+	using Grid = std::array<uint8_t, 81>;
+
+private:
+
+	struct Node
+	{
+		uint8_t  t;                 // transposed
+		uint8_t  next;              // last label used
+		uint16_t rows;              // rows already placed
+		std::array<uint8_t, 9>  row;
+		std::array<uint8_t, 9>  col;
+		std::array<uint8_t, 10> map;
+	};
+
+	static constexpr uint8_t perm[6][3] = { {0,1,2}, {0,2,1}, {1,0,2}, {1,2,0}, {2,0,1}, {2,1,0} };
+
+	std::array<Grid, 2> view;
+	std::vector<Node>   cur;
+	std::vector<Node>   nxt;
+
+	// the first row: every arrangement of columns giving the minimal pattern of givens
+	void first()
+	{
+		uint top = 1U << 9;
+
+		for (uint8_t t = 0; t < 2; t++)
+		{
+			for (uint8_t r = 0; r < 9; r++)
+			{
+				const uint8_t *v = &SudokuMinlex::view[t][r * 9];
+				uint cnt[3];
+				for (uint s = 0; s < 3; s++)
+					cnt[s] = static_cast<uint>((v[s * 3] != 0) + (v[s * 3 + 1] != 0) + (v[s * 3 + 2] != 0));
+
+				uint pat = 0;
+				for (uint i = 0; i < 6; i++)
+				{
+					const uint8_t *p = perm[i];
+					if (cnt[p[0]] > cnt[p[1]] || cnt[p[1]] > cnt[p[2]])
+						continue;
+					pat = 0;
+					for (uint s = 0; s < 3; s++)
+						pat = (pat << 3) | ((1U << cnt[p[s]]) - 1);
+					break;
+				}
+
+				if (pat > top)
+					continue;
+				if (pat < top)
+				{
+					top = pat;
+					SudokuMinlex::cur.clear();
+				}
+
+				SudokuMinlex::columns(t, r, cnt);
+			}
+		}
+	}
+
+	void columns( uint8_t t, uint8_t r, const uint *cnt )
+	{
+		const uint8_t *v = &SudokuMinlex::view[t][r * 9];
+
+		// column orders of each stack with the empty cells first
+		uint8_t ord[3][6][3];
+		uint    len[3];
+		for (uint s = 0; s < 3; s++)
+		{
+			len[s] = 0;
+			for (const auto &q: perm)
+			{
+				uint8_t a = v[s * 3 + q[0]] != 0, b = v[s * 3 + q[1]] != 0, c = v[s * 3 + q[2]] != 0;
+				if (a > b || b > c)
+					continue;
+				for (uint k = 0; k < 3; k++)
+					ord[s][len[s]][k] = static_cast<uint8_t>(s * 3 + q[k]);
+				len[s]++;
+			}
+		}
+
+		Node n{};
+		n.t = t;
+		n.rows = static_cast<uint16_t>(1U << r);
+		n.row[0] = r;
+
+		for (const auto &p: perm)
+		{
+			if (cnt[p[0]] > cnt[p[1]] || cnt[p[1]] > cnt[p[2]])
+				continue;
+			for (uint i = 0; i < len[p[0]]; i++)
+			for (uint j = 0; j < len[p[1]]; j++)
+			for (uint k = 0; k < len[p[2]]; k++)
+			{
+				for (uint x = 0; x < 3; x++)
+				{
+					n.col[x]     = ord[p[0]][i][x];
+					n.col[x + 3] = ord[p[1]][j][x];
+					n.col[x + 6] = ord[p[2]][k][x];
+				}
+				n.map  = {};
+				n.next = 0;
+				for (uint x = 0; x < 9; x++)
+				{
+					uint8_t d = v[n.col[x]];
+					if (d != 0)
+						n.map[d] = ++n.next;
+				}
+				SudokuMinlex::cur.push_back(n);
+			}
+		}
+	}
+
+	// the k-th row: the best of the rows allowed by the band structure
+	void next( uint k )
+	{
+		uint8_t best[9];
+		std::fill(best, best + 9, UINT8_MAX);
+		SudokuMinlex::nxt.clear();
+
+		for (const Node &node: SudokuMinlex::cur)
+		{
+			uint lo = 0, hi = 9;
+			if (k % 3 != 0)
+				lo = node.row[k - 1] / 3 * 3, hi = lo + 3;
+
+			for (uint r = lo; r < hi; r++)
+			{
+				uint band = 7U << (r / 3 * 3);
+				if (k % 3 == 0 ? (node.rows & band) != 0 : (node.rows >> r) & 1)
+					continue;
+
+				const uint8_t *v = &SudokuMinlex::view[node.t][r * 9];
+				Node n = node;
+				uint8_t out[9];
+				int cmp = 0;
+				uint x = 0;
+				for (; x < 9; x++)
+				{
+					uint8_t d = v[n.col[x]];
+					out[x] = d == 0 ? 0 : n.map[d] != 0 ? n.map[d] : (n.map[d] = ++n.next);
+					if (cmp == 0 && out[x] != best[x])
+					{
+						if (out[x] > best[x])
+							break;
+						cmp = -1;
+					}
+				}
+				if (x < 9)
+					continue;
+
+				if (cmp < 0)
+				{
+					std::copy(out, out + 9, best);
+					SudokuMinlex::nxt.clear();
+				}
+
+				n.row[k] = static_cast<uint8_t>(r);
+				n.rows |= static_cast<uint16_t>(1U << r);
+				SudokuMinlex::nxt.push_back(n);
+			}
+		}
+
+		std::swap(SudokuMinlex::cur, SudokuMinlex::nxt);
+	}
+
+public:
+
+	Grid canon( const Grid &tab )
+	{
+		for (uint r = 0; r < 9; r++)
+			for (uint c = 0; c < 9; c++)
+				SudokuMinlex::view[0][r * 9 + c] = SudokuMinlex::view[1][c * 9 + r] = tab[r * 9 + c];
+
+		SudokuMinlex::cur.clear();
+		SudokuMinlex::first();
+		for (uint k = 1; k < 9; k++)
+			SudokuMinlex::next(k);
+
+		Grid res;
+		const Node &n = SudokuMinlex::cur.front();
+		for (uint r = 0; r < 9; r++)
+			for (uint c = 0; c < 9; c++)
+				res[r * 9 + c] = n.map[SudokuMinlex::view[n.t][n.row[r] * 9U + n.col[c]]];
+
+		return res;
+	}
+
+	// 64-bit key of the canonical form
+	static
+	uint64_t key( const Grid &res )
+	{
+		auto data = SudokuHash::pack(res);
+		return SudokuHash::hash64(data.data(), data.size());
+	}
+};
@@ -620,6 +620,8 @@ void GameFooter::update( Console &con, const bool init, const TCHAR *info )
 
 Game::Game(): Console(::title), hdr{}, tab{*this}, mnu{}, ftr{}, timer_f{true}, light_f{false}, help{Assistance::None}, alive{true}, xpos{0}
 {
+	Sudoku::jobs = std::max(std::thread::hardware_concurrency(), 1U);
+
 	Console::SetFont(56, L"Consolas");
 	Console::Center(WIN.width, WIN.height);
 	Console::HideCursor();
@@ -906,8 +908,9 @@ int _tmain( int argc, TCHAR **argv )
 		case _T('f'): // find
 		{
 			auto sudoku = Sudoku(Difficulty::Medium);
+			sudoku.target = ext == _T('x') ? 0 : INT_MIN;
 			auto timer  = GameTimer<int>();
-			auto data   = std::vector<uint32_t>();
+			auto data   = SudokuIndex();
 
 			if (--argc > 0)
 				file = *++argv;
@@ -920,9 +923,9 @@ int _tmain( int argc, TCHAR **argv )
 				sudoku.generate();
 				if (ext == _T('r') || ext == _T('x'))
 					sudoku.raise(ext == _T('x'));
-				if (std::find(data.begin(), data.end(), sudoku.signature) == data.end() && sudoku.test(ext != _T('x')))
+				if (uint64_t key = data.key(sudoku); !data.contains(key) && sudoku.test(ext != _T('x')))
 				{
-					data.push_back(sudoku.signature);
+					data.insert(key);
 					std::cout << sudoku << std::endl;
 					sudoku.append(file);
 				}
@@ -935,8 +938,9 @@ int _tmain( int argc, TCHAR **argv )
 		case _T('t'): // test
 		{
 			auto sudoku = Sudoku(Difficulty::Medium);
+			sudoku.target = 0;
 			auto timer  = GameTimer<int>();
-			auto data   = std::vector<uint32_t>();
+			auto data   = SudokuIndex();
 			auto coll   = std::vector<Sudoku>();
 			auto lst    = std::vector<std::basic_string<TCHAR>>();
 
@@ -951,9 +955,9 @@ int _tmain( int argc, TCHAR **argv )
 			{
 				std::cerr << ' ' << ++cnt << '\r';
 				sudoku.init(i);
-				if (std::find(data.begin(), data.end(), sudoku.signature) == data.end() && sudoku.test(false))
+				if (uint64_t key = data.key(sudoku); !data.contains(key) && sudoku.test(false))
 				{
-					data.push_back(sudoku.signature);
+					data.insert(key);
 					coll.emplace_back(sudoku);
 				}
 			}
@@ -971,7 +975,7 @@ int _tmain( int argc, TCHAR **argv )
 		{
 			auto sudoku = Sudoku(Difficulty::Medium);
 			auto timer  = GameTimer<int>();
-			auto data   = std::vector<uint32_t>();
+			auto data   = SudokuIndex();
 			auto coll   = std::vector<Sudoku>();
 			auto lst    = std::vector<std::basic_string<TCHAR>>();
 
@@ -986,9 +990,9 @@ int _tmain( int argc, TCHAR **argv )
 			{
 				std::cerr << ' ' << ++cnt << '\r';
 				sudoku.init(i);
-				if (std::find(data.begin(), data.end(), sudoku.signature) == data.end() && sudoku.test(true))
+				if (uint64_t key = data.key(sudoku); !data.contains(key) && sudoku.test(true))
 				{
-					data.push_back(sudoku.signature);
+					data.insert(key);
 					coll.emplace_back(sudoku);
 				}
 			}
@@ -1005,8 +1009,9 @@ int _tmain( int argc, TCHAR **argv )
 		case _T('r'): // raise
 		{
 			auto sudoku = Sudoku(Difficulty::Medium);
+			sudoku.target = ext == _T('x') ? 0 : INT_MIN;
 			auto timer  = GameTimer<int>();
-			auto data   = std::vector<uint32_t>();
+			auto data   = SudokuIndex();
 			auto lst    = std::vector<std::basic_string<TCHAR>>();
 
 
@@ -1022,9 +1027,9 @@ int _tmain( int argc, TCHAR **argv )
 				std::cerr << ' ' << ++cnt << '\r';
 				sudoku.init(i);
 				sudoku.raise(ext == _T('x'));
-				if (std::find(data.begin(), data.end(), sudoku.signature) == data.end() && sudoku.test(ext != _T('x')))
+				if (uint64_t key = data.key(sudoku); !data.contains(key) && sudoku.test(ext != _T('x')))
 				{
-					data.push_back(sudoku.signature);
+					data.insert(key);
 					std::cout << sudoku << std::endl;
 				}
 			}
@@ -0,0 +1,137 @@
+/******************************************************************************
+
+   @file    workers.hpp
+   @author  Rajmund Szymanski
+   @date    29.12.2020
+   @brief   persistent worker threads of the parallel rating and raise
+
+*******************************************************************************
+
+   Copyright (c) 2018 - 2020 Rajmund Szymanski. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+
+******************************************************************************/
+
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+// The worker threads are started at the first parallel job and kept to the end,
+// so a rating or a raise step does not pay for the creation of its threads and
+// the thread-local tables of the engine (the rating memo, the solvers) are kept
+// from one job to the next. A job is run by the caller and by the workers it asks
+// for; a job asked for by a worker, or while another job is running, is run by
+// the caller alone.
+
+class SudokuWorkers
+{
+	using uint = unsigned int;
+
+	std::atomic<bool>        running{false}; // one job at a time
+	std::mutex               mtx;
+	std::condition_variable  cnd;
+	std::vector<std::thread> pool;
+	std::function<void()>    job;
+	uint64_t                 gen{0};  // number of the current job
+	uint                     want{0}; // workers asked for by the current job
+	uint                     busy{0}; // workers still running it
+	bool                     stop{false};
+
+	static thread_local bool worker;
+
+	void loop( uint id )
+	{
+		SudokuWorkers::worker = true;
+
+		uint64_t seen = 0;
+		std::unique_lock<std::mutex> lock(SudokuWorkers::mtx);
+		for (;;)
+		{
+			SudokuWorkers::cnd.wait(lock, [this, &seen]{ return SudokuWorkers::stop || SudokuWorkers::gen != seen; });
+			if (SudokuWorkers::stop)
+				return;
+			seen = SudokuWorkers::gen;
+			if (id >= SudokuWorkers::want)
+				continue;
+			lock.unlock();
+			SudokuWorkers::job();
+			lock.lock();
+			if (--SudokuWorkers::busy == 0)
+				SudokuWorkers::cnd.notify_all();
+		}
+	}
+
+public:
+
+	SudokuWorkers() = default;
+	SudokuWorkers( const SudokuWorkers & ) = delete;
+	SudokuWorkers &operator=( const SudokuWorkers & ) = delete;
+
+	~SudokuWorkers()
+	{
+		{
+			std::lock_guard<std::mutex> lock(SudokuWorkers::mtx);
+			SudokuWorkers::stop = true;
+		}
+		SudokuWorkers::cnd.notify_all();
+		for (auto &t: SudokuWorkers::pool)
+			t.join();
+	}
+
+	// true in the worker threads
+	static bool inside() { return SudokuWorkers::worker; }
+
+	// the work is run by the caller and by threads - 1 workers (started if needed); it returns when all of them are done
+	template<class F>
+	void run( uint threads, F &work )
+	{
+		if (threads < 2 || SudokuWorkers::worker || SudokuWorkers::running.exchange(true))
+		{
+			work();
+			return;
+		}
+
+		std::unique_lock<std::mutex> lock(SudokuWorkers::mtx);
+		while (SudokuWorkers::pool.size() < threads - 1)
+			SudokuWorkers::pool.emplace_back(&SudokuWorkers::loop, this, static_cast<uint>(SudokuWorkers::pool.size()));
+		SudokuWorkers::job  = [&work]{ work(); };
+		SudokuWorkers::want = threads - 1;
+		SudokuWorkers::busy = threads - 1;
+		SudokuWorkers::gen++;
+		SudokuWorkers::cnd.notify_all();
+		lock.unlock();
+
+		work();
+
+		lock.lock();
+		SudokuWorkers::cnd.wait(lock, [this]{ return SudokuWorkers::busy == 0; });
+		SudokuWorkers::job = nullptr;
+		SudokuWorkers::running = false;
+	}
+};
+
+inline thread_local
+bool SudokuWorkers::worker = false;
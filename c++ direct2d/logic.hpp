@@ -0,0 +1,607 @@
+/******************************************************************************
+
+   @file    logic.hpp
+   @author  Rajmund Szymanski
+   @date    29.12.2020
+   @brief   logical solver: grading by the techniques a human solver needs
+
+*******************************************************************************
+
+   Copyright (c) 2018 - 2020 Rajmund Szymanski. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+
+******************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+
+// The layout is solved step by step with the easiest technique that makes
+// any progress (a digit placed or a candidate eliminated). The grade is the
+// hardest technique needed and a score, the sum of the weights of the steps
+// (singles weigh nothing). Every step takes polynomial time; a layout that
+// needs more than the techniques below is graded as Unsolved.
+
+class SudokuLogic
+{
+	using uint = unsigned int;
+
+public:
+
+	enum class Technique: uint8_t
+	{
+		None,
+		NakedSingle,
+		HiddenSingle,
+		LockedCandidates, // pointing and claiming
+		NakedPair,
+		HiddenPair,
+		NakedTriple,
+		XWing,
+		HiddenTriple,
+		XYWing,
+		NakedQuad,
+		XYZWing,
+		Swordfish,
+		HiddenQuad,
+		XChain,           // alternating chain of strong and weak links of one digit
+		Jellyfish,
+		XYChain,          // chain of bivalue cells
+		Unsolved,
+	};
+
+	static constexpr uint TECHNIQUES = static_cast<uint>(Technique::Unsolved) + 1;
+
+	static constexpr std::array<uint, TECHNIQUES> weight =
+	{ 0, 0, 0, 1, 2, 2, 3, 3, 3, 4, 4, 4, 5, 5, 6, 6, 7, 0 };
+
+	static constexpr std::array<const char *, TECHNIQUES> name =
+	{
+		"none", "naked single", "hidden single", "locked candidates", "naked pair", "hidden pair",
+		"naked triple", "x-wing", "hidden triple", "xy-wing", "naked quad", "xyz-wing",
+		"swordfish", "hidden quad", "x-chain", "jellyfish", "xy-chain", "unsolved",
+	};
+
+	struct Grade
+	{
+		Technique hardest{Technique::None};
+		uint      score{0};
+		std::array<uint, TECHNIQUES> steps{}; // number of steps of every technique
+
+		// hardest technique in hundreds, score (up to 99) in units
+		int rating() const { return 100 * static_cast<int>(hardest) + static_cast<int>(std::min(score, 99U)); }
+	};
+
+private:
+
+	struct Table
+	{
+		std::array<std::array<uint8_t, 9>, 27>  unit; // cells of 9 rows, 9 columns and 9 segments
+		std::array<std::array<uint8_t, 20>, 81> peer; // linked cells
+		std::array<std::array<uint8_t, 3>, 81>  home; // row, column and segment of every cell
+	};
+
+	static constexpr
+	bool linked( uint p, uint q )
+	{
+		return p != q && (p / 9 == q / 9 || p % 9 == q % 9 || (p / 27 == q / 27 && p % 9 / 3 == q % 9 / 3));
+	}
+
+	static constexpr
+	Table make()
+	{
+		Table result{};
+		for (uint i = 0; i < 9; i++)
+		{
+			for (uint j = 0; j < 9; j++)
+			{
+				result.unit[i][j]      = static_cast<uint8_t>(i * 9 + j);
+				result.unit[i + 9][j]  = static_cast<uint8_t>(j * 9 + i);
+				result.unit[i + 18][j] = static_cast<uint8_t>((i / 3 * 3 + j / 3) * 9 + i % 3 * 3 + j % 3);
+			}
+		}
+		for (uint p = 0; p < 81; p++)
+		{
+			result.home[p] = { static_cast<uint8_t>(p / 9), static_cast<uint8_t>(9 + p % 9), static_cast<uint8_t>(18 + p / 27 * 3 + p % 9 / 3) };
+			uint k = 0;
+			for (uint q = 0; q < 81; q++)
+				if (linked(p, q))
+					result.peer[p][k++] = static_cast<uint8_t>(q);
+		}
+		return result;
+	}
+
+	static const Table table;
+
+	std::array<uint16_t, 81> cand; // candidates (bit n for digit n)
+	std::array<uint8_t, 81>  val;
+	uint empty;
+	bool broken;
+
+	static uint bits( uint x ) { return static_cast<uint>(std::popcount(x)); }
+	static uint first( uint x ) { return static_cast<uint>(std::countr_zero(x)); }
+
+	void place( uint p, uint n )
+	{
+		if (SudokuLogic::val[p] != 0 || (SudokuLogic::cand[p] & (1U << n)) == 0)
+		{
+			SudokuLogic::broken = true;
+			return;
+		}
+
+		SudokuLogic::val[p]  = static_cast<uint8_t>(n);
+		SudokuLogic::cand[p] = 0;
+		SudokuLogic::empty--;
+		for (uint q: SudokuLogic::table.peer[p])
+			SudokuLogic::eliminate(q, 1U << n);
+	}
+
+	bool eliminate( uint p, uint m )
+	{
+		if ((SudokuLogic::cand[p] & m) == 0)
+			return false;
+
+		SudokuLogic::cand[p] = static_cast<uint16_t>(SudokuLogic::cand[p] & ~m);
+		if (SudokuLogic::cand[p] == 0)
+			SudokuLogic::broken = true;
+		return true;
+	}
+
+	// cells (bit i for the i-th cell of the unit) with the digit n as a candidate
+	uint where( uint u, uint n ) const
+	{
+		uint result = 0;
+		for (uint i = 0; i < 9; i++)
+			if (SudokuLogic::cand[SudokuLogic::table.unit[u][i]] & (1U << n))
+				result |= 1U << i;
+		return result;
+	}
+
+	bool placed( uint u, uint n ) const
+	{
+		for (uint p: SudokuLogic::table.unit[u])
+			if (SudokuLogic::val[p] == n)
+				return true;
+		return false;
+	}
+
+	bool naked_single()
+	{
+		for (uint p = 0; p < 81; p++)
+		{
+			if (SudokuLogic::val[p] == 0 && bits(SudokuLogic::cand[p]) == 1)
+			{
+				SudokuLogic::place(p, first(SudokuLogic::cand[p]));
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool hidden_single()
+	{
+		for (uint u = 0; u < 27; u++)
+		{
+			for (uint n = 1; n <= 9; n++)
+			{
+				uint m = SudokuLogic::where(u, n);
+				if (bits(m) == 1)
+				{
+					SudokuLogic::place(SudokuLogic::table.unit[u][first(m)], n);
+					return true;
+				}
+				if (m == 0 && !SudokuLogic::placed(u, n))
+				{
+					SudokuLogic::broken = true;
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	// the candidates of a digit in the unit u all lie in the unit v: the rest of v loses them
+	bool locked_candidates()
+	{
+		for (uint u = 0; u < 27; u++)
+		{
+			for (uint n = 1; n <= 9; n++)
+			{
+				uint m = SudokuLogic::where(u, n);
+				if (bits(m) < 2)
+					continue;
+
+				// a line confined to a segment, a segment confined to a row or a column
+				for (uint k = u < 18 ? 2 : 0; k < (u < 18 ? 3U : 2U); k++)
+				{
+					uint v = 81;
+					for (uint i = 0; i < 9; i++)
+					{
+						if (m & (1U << i))
+						{
+							uint h = SudokuLogic::table.home[SudokuLogic::table.unit[u][i]][k];
+							v = v == 81 || v == h ? h : 82;
+						}
+					}
+					if (v > 27)
+						continue;
+
+					bool success = false;
+					for (uint p: SudokuLogic::table.unit[v])
+						if (SudokuLogic::table.home[p][u / 9] != u)
+							success |= SudokuLogic::eliminate(p, 1U << n);
+					if (success)
+						return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	// k cells of a unit with k candidates in total: the rest of the unit loses them
+	bool naked_subset( uint k )
+	{
+		for (uint u = 0; u < 27; u++)
+		{
+			for (uint s = 0; s < 512; s++)
+			{
+				if (bits(s) != k)
+					continue;
+
+				uint m = 0;
+				bool valid = true;
+				for (uint i = 0; i < 9 && valid; i++)
+				{
+					if (s & (1U << i))
+					{
+						uint p = SudokuLogic::table.unit[u][i];
+						valid = SudokuLogic::val[p] == 0;
+						m |= SudokuLogic::cand[p];
+					}
+				}
+				if (!valid || bits(m) != k)
+					continue;
+
+				bool success = false;
+				for (uint i = 0; i < 9; i++)
+					if ((s & (1U << i)) == 0)
+						success |= SudokuLogic::eliminate(SudokuLogic::table.unit[u][i], m);
+				if (success)
+					return true;
+			}
+		}
+		return false;
+	}
+
+	// k digits of a unit confined to k cells: the cells lose all other candidates
+	bool hidden_subset( uint k )
+	{
+		for (uint u = 0; u < 27; u++)
+		{
+			std::array<uint, 10> w{};
+			for (uint n = 1; n <= 9; n++)
+				w[n] = SudokuLogic::where(u, n);
+
+			for (uint d = 2; d < 1024; d += 2)
+			{
+				if (bits(d) != k)
+					continue;
+
+				uint s = 0;
+				bool valid = true;
+				for (uint n = 1; n <= 9 && valid; n++)
+				{
+					if (d & (1U << n))
+					{
+						valid = w[n] != 0;
+						s |= w[n];
+					}
+				}
+				if (!valid || bits(s) != k)
+					continue;
+
+				bool success = false;
+				for (uint i = 0; i < 9; i++)
+					if (s & (1U << i))
+						success |= SudokuLogic::eliminate(SudokuLogic::table.unit[u][i], ~d & 0x3FE);
+				if (success)
+					return true;
+			}
+		}
+		return false;
+	}
+
+	// the candidates of a digit in k rows (columns) lie in k columns (rows): the rest of these columns (rows) loses them
+	bool fish( uint k )
+	{
+		for (uint n = 1; n <= 9; n++)
+		{
+			for (uint base = 0; base <= 9; base += 9)
+			{
+				std::array<uint, 9> w{};
+				for (uint i = 0; i < 9; i++)
+					w[i] = SudokuLogic::where(base + i, n);
+
+				for (uint s = 0; s < 512; s++)
+				{
+					if (bits(s) != k)
+						continue;
+
+					uint m = 0;
+					bool valid = true;
+					for (uint i = 0; i < 9 && valid; i++)
+					{
+						if (s & (1U << i))
+						{
+							valid = w[i] != 0;
+							m |= w[i];
+						}
+					}
+					if (!valid || bits(m) != k)
+						continue;
+
+					bool success = false;
+					for (uint j = 0; j < 9; j++)
+						if (m & (1U << j))
+							for (uint i = 0; i < 9; i++)
+								if ((s & (1U << i)) == 0)
+									success |= SudokuLogic::eliminate(SudokuLogic::table.unit[base + i][j], 1U << n);
+					if (success)
+						return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	// eliminate the candidates m from the cells seeing all the given cells
+	bool eliminate_common( uint m, uint a, uint b, uint c = 81 )
+	{
+		bool success = false;
+		for (uint p = 0; p < 81; p++)
+			if (SudokuLogic::val[p] == 0 && linked(p, a) && linked(p, b) && (c == 81 || linked(p, c)))
+				success |= SudokuLogic::eliminate(p, m);
+		return success;
+	}
+
+	bool xy_wing()
+	{
+		for (uint p = 0; p < 81; p++)
+		{
+			uint cp = SudokuLogic::cand[p];
+			if (SudokuLogic::val[p] != 0 || bits(cp) != 2)
+				continue;
+
+			for (uint a: SudokuLogic::table.peer[p])
+			{
+				uint ca = SudokuLogic::cand[a];
+				if (bits(ca) != 2 || bits(ca & cp) != 1)
+					continue;
+				uint z = ca & ~cp;
+
+				for (uint b: SudokuLogic::table.peer[p])
+				{
+					if (b == a || SudokuLogic::cand[b] != ((cp & ~ca) | z))
+						continue;
+					if (SudokuLogic::eliminate_common(z, a, b))
+						return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	bool xyz_wing()
+	{
+		for (uint p = 0; p < 81; p++)
+		{
+			uint cp = SudokuLogic::cand[p];
+			if (SudokuLogic::val[p] != 0 || bits(cp) != 3)
+				continue;
+
+			for (uint a: SudokuLogic::table.peer[p])
+			{
+				uint ca = SudokuLogic::cand[a];
+				if (bits(ca) != 2 || (ca & ~cp) != 0)
+					continue;
+
+				for (uint b: SudokuLogic::table.peer[p])
+				{
+					uint cb = SudokuLogic::cand[b];
+					if (b == a || bits(cb) != 2 || (cb & ~cp) != 0 || (ca | cb) != cp)
+						continue;
+					if (SudokuLogic::eliminate_common(ca & cb, p, a, b))
+						return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	// whether p and q are the only cells of some unit with the digit n (strong link); c: number of cells with n in every unit
+	static
+	bool conjugate( uint p, uint q, const std::array<uint, 27> &c )
+	{
+		for (uint k = 0; k < 3; k++)
+		{
+			uint u = SudokuLogic::table.home[p][k];
+			if (SudokuLogic::table.home[q][k] == u && c[u] == 2)
+				return true;
+		}
+		return false;
+	}
+
+	// if the start cell is not n, the digit n is forced into every cell reached by a strong link,
+	// so any cell seeing both the start and such a cell cannot be n
+	bool x_chain()
+	{
+		for (uint n = 1; n <= 9; n++)
+		{
+			uint bit = 1U << n;
+			std::array<uint, 27> c;
+			for (uint u = 0; u < 27; u++)
+				c[u] = bits(SudokuLogic::where(u, n));
+
+			for (uint s = 0; s < 81; s++)
+			{
+				if ((SudokuLogic::cand[s] & bit) == 0)
+					continue;
+
+				std::array<uint8_t, 81 * 2> seen{};
+				std::array<uint8_t, 81 * 2> queue;
+				uint head = 0, tail = 0;
+				seen[s * 2] = 1;
+				queue[tail++] = static_cast<uint8_t>(s * 2);
+
+				while (head < tail)
+				{
+					uint x  = queue[head++];
+					uint p  = x / 2;
+					uint on = x % 2;
+					for (uint q: SudokuLogic::table.peer[p])
+					{
+						if ((SudokuLogic::cand[q] & bit) == 0)
+							continue;
+						// off -> on needs a strong link, on -> off any link
+						if (!on && !SudokuLogic::conjugate(p, q, c))
+							continue;
+						uint y = q * 2 + !on;
+						if (seen[y])
+							continue;
+						seen[y] = 1;
+						queue[tail++] = static_cast<uint8_t>(y);
+
+						if (!on && q != s && SudokuLogic::eliminate_common(bit, s, q))
+							return true;
+					}
+				}
+			}
+		}
+		return false;
+	}
+
+	// if the start cell is not x, it is the other digit, which forces the next bivalue cell and so on;
+	// a cell of the chain forced to x means that any cell seeing both ends cannot be x
+	bool xy_chain()
+	{
+		for (uint s = 0; s < 81; s++)
+		{
+			if (SudokuLogic::val[s] != 0 || bits(SudokuLogic::cand[s]) != 2)
+				continue;
+
+			for (uint x = 1; x <= 9; x++)
+			{
+				if ((SudokuLogic::cand[s] & (1U << x)) == 0)
+					continue;
+
+				std::array<uint8_t, 81 * 10> seen{};
+				std::array<uint16_t, 81 * 10> queue;
+				uint head = 0, tail = 0;
+				uint y = s * 10 + first(SudokuLogic::cand[s] & ~(1U << x));
+				seen[y] = 1;
+				queue[tail++] = static_cast<uint16_t>(y);
+
+				while (head < tail)
+				{
+					uint p = queue[head] / 10;
+					uint v = queue[head++] % 10;
+					for (uint q: SudokuLogic::table.peer[p])
+					{
+						uint cq = SudokuLogic::cand[q];
+						if (SudokuLogic::val[q] != 0 || bits(cq) != 2 || (cq & (1U << v)) == 0)
+							continue;
+						uint w = first(cq & ~(1U << v));
+						if (seen[q * 10 + w])
+							continue;
+						seen[q * 10 + w] = 1;
+						queue[tail++] = static_cast<uint16_t>(q * 10 + w);
+
+						if (w == x && q != s && SudokuLogic::eliminate_common(1U << x, s, q))
+							return true;
+					}
+				}
+			}
+		}
+		return false;
+	}
+
+	Technique step()
+	{
+		if (SudokuLogic::naked_single())      return Technique::NakedSingle;
+		if (SudokuLogic::hidden_single())     return Technique::HiddenSingle;
+		if (SudokuLogic::locked_candidates()) return Technique::LockedCandidates;
+		if (SudokuLogic::naked_subset(2))     return Technique::NakedPair;
+		if (SudokuLogic::hidden_subset(2))    return Technique::HiddenPair;
+		if (SudokuLogic::naked_subset(3))     return Technique::NakedTriple;
+		if (SudokuLogic::fish(2))             return Technique::XWing;
+		if (SudokuLogic::hidden_subset(3))    return Technique::HiddenTriple;
+		if (SudokuLogic::xy_wing())           return Technique::XYWing;
+		if (SudokuLogic::naked_subset(4))     return Technique::NakedQuad;
+		if (SudokuLogic::xyz_wing())          return Technique::XYZWing;
+		if (SudokuLogic::fish(3))             return Technique::Swordfish;
+		if (SudokuLogic::hidden_subset(4))    return Technique::HiddenQuad;
+		if (SudokuLogic::x_chain())           return Technique::XChain;
+		if (SudokuLogic::fish(4))             return Technique::Jellyfish;
+		if (SudokuLogic::xy_chain())          return Technique::XYChain;
+		return Technique::None;
+	}
+
+public:
+
+	// T is any 81-element table of cells with the 'num' member
+	template<class T>
+	Grade grade( const T &tab )
+	{
+		Grade result{};
+
+		SudokuLogic::cand.fill(0x3FE);
+		SudokuLogic::val.fill(0);
+		SudokuLogic::empty  = 81;
+		SudokuLogic::broken = false;
+
+		for (uint p = 0; p < 81 && !SudokuLogic::broken; p++)
+			if (tab[p].num != 0)
+				SudokuLogic::place(p, tab[p].num);
+
+		while (SudokuLogic::empty > 0 && !SudokuLogic::broken)
+		{
+			Technique t = SudokuLogic::step();
+			if (t == Technique::None)
+				break;
+			result.steps[static_cast<uint>(t)]++;
+			result.score += SudokuLogic::weight[static_cast<uint>(t)];
+			result.hardest = std::max(result.hardest, t);
+		}
+
+		if (SudokuLogic::empty > 0 || SudokuLogic::broken)
+			result.hardest = Technique::Unsolved;
+
+		return result;
+	}
+
+	// the solution found (0 for the cells left unsolved)
+	uint get( uint p ) const { return SudokuLogic::val[p]; }
+};
+
+inline constexpr
+SudokuLogic::Table SudokuLogic::table = SudokuLogic::make();
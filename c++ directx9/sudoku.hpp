@@ -32,29 +32,126 @@
 #pragma once
 
 #include <list>
+#include <set>
 #include <array>
 #include <vector>
+#include <tuple>
+#include <optional>
+#include <type_traits>
 #include <utility>
+#include <numeric>
 #include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <fstream>
 #include <random>
+#include <cmath>
+#include <climits>
+#include <cstdint>
+#include <bit>
+#include <ranges>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+#include "dlx.hpp"
+#include "minlex.hpp"
+#include "hash.hpp"
+#include "logic.hpp"
+#include "hitting.hpp"
+#include "workers.hpp"
+#include "pool.hpp"
+
+#if defined(_WIN32)
 #include <tchar.h>
+#else
+using TCHAR = char;
+#define _T(x) x
+#endif
 
 class SudokuCell;
+class SudokuBoard;
 class Sudoku;
 
 using cell_ref = std::reference_wrapper<SudokuCell>;
 using cell_array = std::array<SudokuCell, 81>;
 using uint = unsigned int;
 
-static inline auto gen = std::mt19937{std::random_device{}()};
-
-static inline uint random( uint size )
+// xoshiro256** generator seeded with splitmix64; jump() advances the stream by 2^128 draws,
+// so the streams of one seed taken after 0, 1, 2... jumps never overlap
+class SudokuRandom
 {
-	return std::uniform_int_distribution<uint>{0, size - 1}(gen);
-}
+	uint64_t s[4];
+
+	static uint64_t rotl( uint64_t x, int k ) { return (x << k) | (x >> (64 - k)); }
+
+public:
+
+	using result_type = uint64_t;
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return UINT64_MAX; }
+
+	explicit SudokuRandom( uint64_t x = static_cast<uint64_t>(std::random_device{}()) << 32 | std::random_device{}() ) { SudokuRandom::seed(x); }
+
+	void seed( uint64_t x )
+	{
+		for (uint64_t &v: SudokuRandom::s)
+		{
+			uint64_t z = (x += UINT64_C(0x9E3779B97F4A7C15));
+			z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+			z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+			v = z ^ (z >> 31);
+		}
+	}
+
+	result_type operator()()
+	{
+		uint64_t r = rotl(SudokuRandom::s[1] * 5, 7) * 9;
+		uint64_t t = SudokuRandom::s[1] << 17;
+		SudokuRandom::s[2] ^= SudokuRandom::s[0];
+		SudokuRandom::s[3] ^= SudokuRandom::s[1];
+		SudokuRandom::s[1] ^= SudokuRandom::s[2];
+		SudokuRandom::s[0] ^= SudokuRandom::s[3];
+		SudokuRandom::s[2] ^= t;
+		SudokuRandom::s[3] = rotl(SudokuRandom::s[3], 45);
+		return r;
+	}
+
+	void jump()
+	{
+		static constexpr uint64_t poly[4] = { 0x180EC6D33CFD0ABA, 0xD5A61266F0C9392C, 0xA9582618E03FC9AA, 0x39ABDC4529B1661C };
+		uint64_t t[4] = {};
+		for (uint64_t p: poly)
+			for (int b = 0; b < 64; b++)
+			{
+				if ((p >> b) & 1)
+					for (int i = 0; i < 4; i++)
+						t[i] ^= SudokuRandom::s[i];
+				(*this)();
+			}
+		std::copy(t, t + 4, SudokuRandom::s);
+	}
+
+	// unbiased value from 0 to n - 1 (multiply and reject)
+	uint below( uint n )
+	{
+		uint64_t m = ((*this)() >> 32) * n;
+		if (static_cast<uint32_t>(m) < n)
+		{
+			uint32_t t = static_cast<uint32_t>(-n) % n;
+			while (static_cast<uint32_t>(m) < t)
+				m = ((*this)() >> 32) * n;
+		}
+		return static_cast<uint>(m >> 32);
+	}
+
+	// value from [0, 1)
+	double real()
+	{
+		return static_cast<double>((*this)() >> 11) * 0x1.0p-53;
+	}
+};
 
 enum Difficulty
 {
@@ -73,6 +170,145 @@ enum class Force
 	Safe,
 };
 
+enum class Engine
+{
+	Backtracking,
+	DLX,
+	Propagation,
+	Iterative,
+};
+
+enum class Grader
+{
+	Search,     // size of the search tree (parse_rating)
+	Logic,      // hardest technique needed and weighted steps (SudokuLogic)
+};
+
+enum class Dedup
+{
+	Signature,  // 32-bit signature, as stored in board files
+	Digest,     // 64-bit wide signature (the givens)
+	Canonical,  // minlex canonical form of the givens
+};
+
+class SudokuBits
+{
+	uint64_t lo{0}; // cells 0..63
+	uint64_t hi{0}; // cells 64..80
+
+	constexpr SudokuBits( uint64_t l, uint64_t h ): lo{l}, hi{h} {}
+
+public:
+
+	constexpr SudokuBits() = default;
+
+	constexpr void set  ( uint p ) { if (p < 64) lo |=  (1ULL << p); else hi |=  (1ULL << (p - 64)); }
+	constexpr void reset( uint p ) { if (p < 64) lo &= ~(1ULL << p); else hi &= ~(1ULL << (p - 64)); }
+
+	constexpr bool any() const { return (lo | hi) != 0; }
+
+	constexpr uint first() const { return lo != 0 ? static_cast<uint>(std::countr_zero(lo)) : hi != 0 ? static_cast<uint>(std::countr_zero(hi)) + 64 : 81; }
+
+	constexpr SudokuBits operator &( const SudokuBits &b ) const { return SudokuBits(lo & b.lo, hi & b.hi); }
+
+	template<class F>
+	void for_each( F f ) const
+	{
+		for (uint64_t m = lo; m != 0; m &= m - 1) f(static_cast<uint>(std::countr_zero(m)));
+		for (uint64_t m = hi; m != 0; m &= m - 1) f(static_cast<uint>(std::countr_zero(m)) + 64);
+	}
+
+	static constexpr
+	SudokuBits all() { return SudokuBits(~0ULL, (1ULL << (81 - 64)) - 1); }
+};
+
+class SudokuLinks
+{
+	using index = std::array<uint8_t, 3>;
+	using units = std::array<uint8_t, 8>;
+	using peers = std::array<uint8_t, 20>;
+	using cells = std::array<uint8_t, 9>;
+
+	template<class T, class F>
+	static constexpr
+	std::array<T, 81> make( F in )
+	{
+		std::array<T, 81> result{};
+		for (uint p = 0; p < 81; p++)
+		{
+			uint i = 0;
+			for (uint q = 0; q < 81; q++)
+				if (in(p, q))
+					result[p][i++] = static_cast<uint8_t>(q);
+		}
+		return result;
+	}
+
+	static constexpr
+	std::array<SudokuBits, 81> link()
+	{
+		std::array<SudokuBits, 81> result{};
+		for (uint p = 0; p < 81; p++)
+			for (uint q = 0; q < 81; q++)
+				if (in_lst(p, q))
+					result[p].set(q);
+		return result;
+	}
+
+	static constexpr
+	std::array<cells, 27> area()
+	{
+		std::array<cells, 27> result{};
+		std::array<uint, 27> size{};
+		for (uint p = 0; p < 81; p++)
+			for (uint u: make()[p])
+				result[u][size[u]++] = static_cast<uint8_t>(p);
+		return result;
+	}
+
+	static constexpr
+	std::array<index, 81> make()
+	{
+		std::array<index, 81> result{};
+		for (uint p = 0; p < 81; p++)
+			result[p] = { static_cast<uint8_t>(p / 9), static_cast<uint8_t>(p % 9 + 9), static_cast<uint8_t>((p / 27) * 3 + (p % 9) / 3 + 18) };
+		return result;
+	}
+
+public:
+
+	static constexpr bool in_row( uint p1, uint p2 ) { return p1 != p2 && p1 / 9 == p2 / 9; }
+	static constexpr bool in_col( uint p1, uint p2 ) { return p1 != p2 && p1 % 9 == p2 % 9; }
+	static constexpr bool in_seg( uint p1, uint p2 ) { return p1 != p2 && p1 / 27 == p2 / 27 && (p1 % 9) / 3 == (p2 % 9) / 3; }
+	static constexpr bool in_lst( uint p1, uint p2 ) { return in_row(p1, p2) || in_col(p1, p2) || in_seg(p1, p2); }
+
+	struct Table
+	{
+		std::array<index, 81> unit; // row, column and segment of the cell (units 0..26)
+		std::array<units, 81> row;
+		std::array<units, 81> col;
+		std::array<units, 81> seg;
+		std::array<peers, 81> lst;  // all linked cells, in ascending order
+		std::array<SudokuBits, 81> bits; // all linked cells, as a set
+		std::array<cells, 27> area; // cells of every unit
+	};
+
+	static const
+	Table table;
+};
+
+inline constexpr
+SudokuLinks::Table SudokuLinks::table =
+{
+	SudokuLinks::make(),
+	SudokuLinks::make<SudokuLinks::units>(SudokuLinks::in_row),
+	SudokuLinks::make<SudokuLinks::units>(SudokuLinks::in_col),
+	SudokuLinks::make<SudokuLinks::units>(SudokuLinks::in_seg),
+	SudokuLinks::make<SudokuLinks::peers>(SudokuLinks::in_lst),
+	SudokuLinks::link(),
+	SudokuLinks::area(),
+};
+
 class SudokuCell
 {
 	using Cell = SudokuCell;
@@ -87,16 +323,14 @@ public:
 	{
 	public:
 
-		Values( Cell &cell, bool shuffled = false )
+		Values( Cell &cell, SudokuRandom *rnd = nullptr )
 		{
-		 	std::iota(Values::begin(), Values::end(), 0);
+			uint m = cell.mask();
+			for (uint v = 0; v < 10; v++)
+				Values::at(v) = (m & (1U << v)) ? v : 0;
 
-			Values::at(cell.num) = 0;
-			for (Cell &c: cell.lst)
-				Values::at(c.num) = 0;
-
-			if (shuffled)
-				std::shuffle(Values::begin(), Values::end(), gen);
+			if (rnd != nullptr)
+				std::shuffle(Values::begin(), Values::end(), *rnd);
 		}
 
 		uint len()
@@ -107,60 +341,19 @@ public:
 
 private:
 
-	std::vector<cell_ref> row{};
-	std::vector<cell_ref> col{};
-	std::vector<cell_ref> seg{};
-	std::vector<cell_ref> lst{};
-
-	bool in_row( const Cell &c )
+	template<size_t N>
+	auto link( const std::array<uint8_t, N> &idx )
 	{
-		if (Cell::pos == c.pos)
-			return false;
-
-		uint r1 = Cell::pos / 9;
-		uint r2 = c.pos / 9;
-
-		return r1 == r2;
-	}
-
-	bool in_col( const Cell &c )
-	{
-		if (Cell::pos == c.pos)
-			return false;
-
-		uint c1 = Cell::pos % 9;
-		uint c2 = c.pos % 9;
-
-		return c1 == c2;
+		Cell * const tab = this - Cell::pos;
+		return std::views::transform(idx, [tab]( uint p ) -> Cell & { return tab[p]; });
 	}
 
-	bool in_seg( const Cell &c )
-	{
-		if (Cell::pos == c.pos)
-			return false;
-
-		uint r1 = Cell::pos / 9;
-		uint r2 = c.pos / 9;
-		uint c1 = Cell::pos % 9;
-		uint c2 = c.pos % 9;
-		uint s1 = (r1 / 3) * 3 + (c1 / 3);
-		uint s2 = (r2 / 3) * 3 + (c2 / 3);
-
-		return s1 == s2;
-	}
-	
-	bool in_lst( const Cell &c )
-	{
-		return Cell::in_row(c) || Cell::in_col(c) || Cell::in_seg(c);
-	}
+	auto row() { return Cell::link(SudokuLinks::table.row[Cell::pos]); }
+	auto col() { return Cell::link(SudokuLinks::table.col[Cell::pos]); }
+	auto seg() { return Cell::link(SudokuLinks::table.seg[Cell::pos]); }
+	auto lst() { return Cell::link(SudokuLinks::table.lst[Cell::pos]); }
 
-	void link( Cell &c )
-	{
-		if (Cell::in_row(c)) Cell::row.push_back(std::ref(c));
-		if (Cell::in_col(c)) Cell::col.push_back(std::ref(c));
-		if (Cell::in_seg(c)) Cell::seg.push_back(std::ref(c));
-		if (Cell::in_lst(c)) Cell::lst.push_back(std::ref(c));
-	}
+	inline SudokuBoard &tab();
 
 public:
 
@@ -169,39 +362,26 @@ public:
 		if (c == nullptr)
 			return false;
 
-		return in_lst(*c);
+		return SudokuLinks::in_lst(Cell::pos, c->pos);
 	}
 
 	void init( uint p )
 	{
 		Cell::pos = p;
-
-		std::for_each(this - p, this, [this]( Cell &c )
-		{
-			Cell::link(c);
-			c.link(*this);
-		});
-	}
-
-	uint len()
-	{
-		if (Cell::num != 0)
-			return 0;
-
-		return Cell::Values(*this).len();
 	}
 
-	uint range()
-	{
-		return std::accumulate(std::begin(Cell::lst), std::end(Cell::lst), 0U, []( uint r, Cell &c ){ return r + c.len(); });
-	}
+	inline uint mask();           // available values (bit n for value n)
+	inline void put( uint n );    // the only way to change the digit
+	inline bool repeated();
+	inline uint len();            // number of available values (0 for a filled cell)
+	inline uint range();          // sum of the lengths of the linked cells
 
 	uint solid()
 	{
 		if (Cell::num == 0)
 			return 0;
 
-		return std::count_if(std::begin(Cell::lst), std::end(Cell::lst), []( Cell &c ){ return c.num != 0; }) + 1;
+		return std::ranges::count_if(Cell::lst(), []( Cell &c ){ return c.num != 0; }) + 1;
 	}
 
 	bool empty()
@@ -222,15 +402,15 @@ public:
 		if (n == 0)
 			return true;
 
-		return std::none_of(std::begin(Cell::lst), std::end(Cell::lst), [n]( Cell &c ){ return c.num == n; });
+		return (Cell::mask() & (1U << n)) != 0;
 	}
 
 	bool corrupt()
 	{
 		if (Cell::num == 0)
-			return Cell::len() == 0;
+			return Cell::mask() == 0;
 
-		return std::any_of(std::begin(Cell::lst), std::end(Cell::lst), [this]( Cell &c ){ return c.num == Cell::num; });
+		return Cell::repeated();
 	}
 
 	bool allowed( uint n )
@@ -238,11 +418,11 @@ public:
 		if (Cell::num != 0 || n == 0)
 			return false;
 
-		Cell::num = n;
-		bool result = std::none_of(std::begin(Cell::lst), std::end(Cell::lst), []( Cell &c ){ return c.corrupt(); });
-		Cell::num = 0;
+		uint m = 1U << n;
+		if ((Cell::mask() & m) == 0)
+			return false;
 
-		return result;
+		return std::ranges::none_of(Cell::lst(), [m]( Cell &c ){ return c.num == 0 ? (c.mask() & ~m) == 0 : c.repeated(); });
 	}
 
 	bool accept( uint n )
@@ -264,16 +444,16 @@ public:
 		if (!Cell::allowed(n)) return 0;
 		if ( Cell::len() == 1) return n;
 
-		if (std::none_of(std::begin(Cell::row), std::end(Cell::row), [n]( Cell &c ){ return c.allowed(n); })) return n;
-		if (std::none_of(std::begin(Cell::col), std::end(Cell::col), [n]( Cell &c ){ return c.allowed(n); })) return n;
-		if (std::none_of(std::begin(Cell::seg), std::end(Cell::seg), [n]( Cell &c ){ return c.allowed(n); })) return n;
+		if (std::ranges::none_of(Cell::row(), [n]( Cell &c ){ return c.allowed(n); })) return n;
+		if (std::ranges::none_of(Cell::col(), [n]( Cell &c ){ return c.allowed(n); })) return n;
+		if (std::ranges::none_of(Cell::seg(), [n]( Cell &c ){ return c.allowed(n); })) return n;
 
 		return 0;
 	}
 
 	void clear()
 	{
-		Cell::num = 0;
+		Cell::put(0);
 		Cell::immutable = false;
 	}
 
@@ -282,64 +462,13 @@ public:
 		if (Cell::immutable || (n != 0 && !Cell::allowed(n)))
 			return false;
 
-		Cell::num = n;
+		Cell::put(n);
 		return true;
 	}
 
-	bool solve( bool check = false )
-	{
-		cell_ref c = *std::min_element(std::begin(Cell::lst), std::end(Cell::lst), Cell::by_length);
-		if (c.get().num != 0)
-		{
-			Cell * const tab = this - Cell::pos;
-			c = std::ref(*std::min_element(tab, tab + 81, Cell::by_length));
-			if (c.get().num != 0)
-				return true;
-		}
-
-		Cell &cell = c.get();
-		for (uint v: Cell::Values(cell, true))
-		{
-			if ((cell.num = v) != 0 && cell.solve(check))
-			{
-				if (check)
-					cell.num = 0;
-
-				return true;
-			}
-		}
-
-		cell.num = 0;
-		return false;
-	}
-
-	bool generate( Difficulty level, bool check = false )
-	{
-		if (Cell::num == 0 || Cell::immutable)
-			return false;
-
-		uint n = Cell::num;
-
-		Cell::num = 0;
-		if (Cell::sure(n))
-			return true;
-
-		Cell::num = n;
-		if (level == Difficulty::Easy && !check)
-			return false;
-
-		for (uint v: Cell::Values(*this))
-		{
-			if ((Cell::num = v) != 0 && Cell::solve(true))
-			{
-				Cell::num = n;
-				return false;
-			}
-		}
+	inline bool solve( bool check = false );
 
-		Cell::num = 0;
-		return true;
-	}
+	inline bool generate( Difficulty level, bool check = false );
 
 	static
 	bool by_length( Cell &a, Cell &b )
@@ -367,530 +496,1957 @@ public:
 	}
 };
 
-class Sudoku: public cell_array
+class SudokuBoard: public cell_array
 {
-	using Cell = SudokuCell;
+	friend class SudokuCell;
 
-	static const
-	std::vector<std::basic_string<TCHAR>> extreme;
+	std::array<std::array<uint8_t, 10>, 27> cnt{}; // digit counters of 9 rows, 9 columns and 9 segments
+	std::array<uint, 27>                    msk{}; // 9-bit occupancy masks of the units (bit n for digit n)
+	uint                                    dup{0}; // number of repeated digits on the board
+	std::array<uint8_t, 81>                 len;    // cached length of every cell
+	std::array<uint8_t, 81>                 rng;    // cached range of every cell (sum of the lengths of its peers)
+	std::array<SudokuBits, 10>              lvl{};  // empty cells grouped by their length (bucket queue)
+	uint64_t                                zob{0}; // Zobrist hash of the filled cells
 
-	static const
-	std::basic_string<TCHAR> html;
+	using Keys = std::array<std::array<uint64_t, 10>, 81>;
 
-	std::list<std::pair<Cell *, uint>> mem;
+public:
 
-	class Backup: public std::array<std::tuple<Cell *, uint, bool>, 81>
-	{
-	public:
+	using Counts = std::array<std::array<uint8_t, 10>, 81>;
 
-		Backup( cell_array *tab )
-		{
-			std::transform(std::begin(*tab), std::end(*tab), Backup::begin(), []( Cell &c )
-			{
-				return std::make_tuple(&c, c.num, c.immutable);
-			});
-		}
+	SudokuRandom rnd{}; // random stream of the board
 
-		void reload()
-		{
-			std::for_each(Backup::begin(), Backup::end(), []( std::tuple<Cell *, uint, bool> &t )
-			{
-				Cell *c = std::get<Cell *>(t);
-				std::get<uint>(t) = c->num;
-				std::get<bool>(t) = c->immutable;
-			});
-		}
+private:
 
-		void restore()
+	static constexpr
+	Keys zobrist()
+	{
+		Keys result{};
+		uint64_t x = 0;
+		for (uint p = 0; p < 81; p++)
 		{
-			std::for_each(Backup::begin(), Backup::end(), []( std::tuple<Cell *, uint, bool> &t )
+			for (uint n = 1; n <= 9; n++)
 			{
-				Cell *c = std::get<Cell *>(t);
-				c->num = std::get<uint>(t);
-				c->immutable = std::get<bool>(t);
-			});
+				// splitmix64
+				uint64_t z = (x += UINT64_C(0x9E3779B97F4A7C15));
+				z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+				z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+				result[p][n] = z ^ (z >> 31);
+			}
 		}
+		return result;
+	}
 
-		bool changed()
-		{
-			return std::any_of(Backup::begin(), Backup::end(), []( std::tuple<Cell *, uint, bool> &t )
-			{
-				Cell *c = std::get<Cell *>(t);
-				return c->num != std::get<uint>(t);
-			});
-		}
+	static const
+	Keys keys; // Zobrist keys of the (cell, digit) pairs; an empty cell adds nothing
 
-		uint len()
-		{
-			return std::count_if(Backup::begin(), Backup::end(), []( std::tuple<Cell *, uint, bool> &t )
-			{
-				return std::get<uint>(t) != 0;
-			});
-		}
-	};
+	static uint row( uint p ) { return SudokuLinks::table.unit[p][0]; }
+	static uint col( uint p ) { return SudokuLinks::table.unit[p][1]; }
+	static uint seg( uint p ) { return SudokuLinks::table.unit[p][2]; }
 
-	class Temp: public Sudoku::Backup
+	void insert( uint u, uint n )
 	{
-	public:
+		if (SudokuBoard::cnt[u][n]++ == 0)
+			SudokuBoard::msk[u] |= 1U << n;
+		else
+			SudokuBoard::dup++;
+	}
 
-		Temp( cell_array *tab ): Sudoku::Backup(tab) {}
-		~Temp() { Sudoku::Backup::restore(); }
+	void remove( uint u, uint n )
+	{
+		if (--SudokuBoard::cnt[u][n] == 0)
+			SudokuBoard::msk[u] &= ~(1U << n);
+		else
+			SudokuBoard::dup--;
+	}
 
-		bool reset()
+	uint used( uint p )
+	{
+		return SudokuBoard::msk[row(p)] | SudokuBoard::msk[col(p)] | SudokuBoard::msk[seg(p)];
+	}
+
+	uint count( uint p )
+	{
+		if (SudokuBoard::at(p).num != 0)
+			return 0;
+
+		return static_cast<uint>(std::popcount(~SudokuBoard::used(p) & 0x3FEU));
+	}
+
+	void update( uint p )
+	{
+		uint l = SudokuBoard::count(p);
+		if (l != SudokuBoard::len[p])
 		{
-			return std::all_of(Sudoku::Backup::begin(), Sudoku::Backup::end(), []( std::tuple<Cell *, uint, bool> &t )
+			if (SudokuBoard::at(p).num == 0)
 			{
-				Cell *c = std::get<Cell *>(t);
-				return c->set(std::get<uint>(t));
-			});
+				SudokuBoard::lvl[SudokuBoard::len[p]].reset(p);
+				SudokuBoard::lvl[l].set(p);
+			}
+
+			uint8_t d = static_cast<uint8_t>(l - SudokuBoard::len[p]);
+			SudokuBoard::len[p] = static_cast<uint8_t>(l);
+			for (uint q: SudokuLinks::table.lst[p])
+				SudokuBoard::rng[q] = static_cast<uint8_t>(SudokuBoard::rng[q] + d);
 		}
-	};
+	}
 
-	class Random: public std::vector<cell_ref>
+	void put( uint p, uint n )
 	{
-	public:
+		uint o = SudokuBoard::at(p).num;
 
-		Random( cell_array *tab ): std::vector<cell_ref>(std::begin(*tab), std::end(*tab))
-		{
-			std::shuffle(Random::begin(), Random::end(), gen);
-		}
+		if (o == 0)
+			SudokuBoard::lvl[SudokuBoard::len[p]].reset(p);
 
-		Cell& operator()()
+		if (o != 0)
 		{
-			return Random::at(::random(Random::size()));
+			SudokuBoard::remove(row(p), o);
+			SudokuBoard::remove(col(p), o);
+			SudokuBoard::remove(seg(p), o);
 		}
-	};
-
-	class Sorted: public std::vector<cell_ref>
-	{
-	public:
 
-		Sorted( cell_array *tab, bool(*compare)(Cell &, Cell&) ): std::vector<cell_ref>(std::begin(*tab), std::end(*tab))
+		if (n != 0)
 		{
-			std::sort(Sorted::begin(), Sorted::end(), compare);
+			SudokuBoard::insert(row(p), n);
+			SudokuBoard::insert(col(p), n);
+			SudokuBoard::insert(seg(p), n);
 		}
-	};
 
-public:
+		SudokuBoard::at(p).num = n;
+		SudokuBoard::zob ^= SudokuBoard::keys[p][o] ^ SudokuBoard::keys[p][n];
 
-	Difficulty level;
-	int        rating;
-	uint32_t   signature;
+		// only the cell and its peers can change their length;
+		// each change is passed on to the ranges of their own peers
+		SudokuBoard::update(p);
+		for (uint q: SudokuLinks::table.lst[p])
+			SudokuBoard::update(q);
 
-	Sudoku( Difficulty l = Difficulty::Easy ): mem{}, level{l}, rating{0}, signature{0}
-	{
-		for (Cell &cell: *this)
-		{
-			auto pos = &cell - this->cell_array::data();
-			cell.init(static_cast<uint>(pos));
-		}
+		if (n == 0)
+			SudokuBoard::lvl[SudokuBoard::len[p]].set(p);
 	}
 
-	uint len()
+	bool repeated( uint p, uint n )
 	{
-		return std::count_if(Sudoku::begin(), Sudoku::end(), []( Cell &c ){ return c.num != 0; });
+		return SudokuBoard::dup != 0 &&
+		      (SudokuBoard::cnt[row(p)][n] > 1 || SudokuBoard::cnt[col(p)][n] > 1 || SudokuBoard::cnt[seg(p)][n] > 1);
 	}
 
-	uint count( uint n )
+	uint backtrack( uint limit )
 	{
-		return std::count_if(Sudoku::begin(), Sudoku::end(), [n]( Cell &c ){ return c.num == n; });
-	}
+		uint p = SudokuBoard::choose();
+		if (p == 81)
+			return 1;
 
-	bool empty()
-	{
-		return std::all_of(Sudoku::begin(), Sudoku::end(), []( Cell &c ){ return c.empty(); });
+		SudokuCell &cell = SudokuBoard::at(p);
+		uint result = 0;
+		for (uint m = cell.mask(); m != 0 && result < limit; m &= m - 1)
+		{
+			cell.put(static_cast<uint>(std::countr_zero(m)));
+			result += SudokuBoard::backtrack(limit - result);
+		}
+
+		cell.put(0);
+		return result;
 	}
 
-	bool corrupt()
+	class Trail
 	{
-		for (auto i = Sudoku::begin(); i != Sudoku::end(); i += 9)
-			for (uint n = 1; n <= 9; ++n)
-				if (std::none_of(i, i + 9, [n]( Cell &c ){ return c.accept(n); }))
-					return true;
+	public:
 
-		return std::any_of(Sudoku::begin(), Sudoku::end(), []( Cell &c ){ return c.corrupt(); });
-	}
+		std::array<uint8_t, 81> pos{};  // cells filled by the search, in order
+		std::array<uint8_t, 81> grid{}; // the first solution found
+		uint top{0};
+		uint found{0};
+	};
 
-	bool solved()
+	void assign( Trail &t, uint p, uint n )
 	{
-		return std::none_of(Sudoku::begin(), Sudoku::end(), []( Cell &c ){ return c.empty() || c.corrupt(); });
+		SudokuBoard::put(p, n);
+		t.pos[t.top++] = static_cast<uint8_t>(p);
 	}
 
-	bool set( Cell *cell, uint n, Force force = Force::Direct )
+	void revert( Trail &t, uint mark )
 	{
-		if (cell == nullptr)
-			return false;
-
-		uint t = cell->num;
-
-		if (t == n)
-			return false;
+		while (t.top > mark)
+			SudokuBoard::put(t.pos[--t.top], 0);
+	}
 
-		switch (force)
+	// fill all naked singles (cells with one available value) and hidden singles
+	// (values with one available cell in a unit); false if a contradiction was found
+	bool singles( Trail &t )
+	{
+		for (;;)
 		{
-		case Force::Direct:
-			if (cell->immutable)
-				return false;
-			cell->num = n;
-			break;
-		case Force::Careful:
-			if (!cell->passable(n))
-				return false;
-			cell->num = n;
-			break;
-		case Force::Safe:
-			if (!cell->set(n))
+			if (SudokuBoard::lvl[0].any())
 				return false;
-			break;
-		}
 
-		Sudoku::mem.emplace_back(cell, t);
-		Sudoku::rating = 0;
-		return true;
-	}
+			if (SudokuBoard::lvl[1].any())
+			{
+				uint p = SudokuBoard::lvl[1].first();
+				SudokuBoard::assign(t, p, static_cast<uint>(std::countr_zero(SudokuBoard::at(p).mask())));
+				continue;
+			}
 
-	void clear( bool deep = true )
-	{
-		for (Cell &c: *this)
-			c.clear();
+			bool changed = false;
+			for (uint u = 0; u < 27 && !changed; u++)
+			{
+				uint ones = 0, twos = 0;
+				for (uint p: SudokuLinks::table.area[u])
+				{
+					if (SudokuBoard::at(p).num == 0)
+					{
+						uint m = SudokuBoard::at(p).mask();
+						twos |= ones & m;
+						ones |= m;
+					}
+				}
 
-		if (deep)
-		{
-			Sudoku::rating = 0;
-			Sudoku::signature = 0;
-			if (Sudoku::level > Difficulty::Easy && Sudoku::level < Difficulty::Extreme)
-				Sudoku::level = Difficulty::Medium;
+				if ((ones | SudokuBoard::msk[u]) != 0x3FE)
+					return false;
+
+				uint once = ones & ~twos;
+				if (once != 0)
+				{
+					for (uint p: SudokuLinks::table.area[u])
+					{
+						uint m = SudokuBoard::at(p).num == 0 ? SudokuBoard::at(p).mask() & once : 0;
+						if (m != 0)
+						{
+							SudokuBoard::assign(t, p, static_cast<uint>(std::countr_zero(m)));
+							changed = true;
+							break;
+						}
+					}
+				}
+			}
+
+			if (!changed)
+				return true;
 		}
 	}
 
-	void discard()
+	// whether any solution of the layout can change any of the counts
+	bool open( const Counts &sols, const SudokuBits &area )
 	{
-		for (Cell &c: *this)
-			c.immutable = false;
+		bool result = false;
+		area.for_each([this, &sols, &result]( uint p )
+		{
+			SudokuCell &c = SudokuBoard::at(p);
+			for (uint m = c.num != 0 ? 1U << c.num : c.mask(); m != 0 && !result; m &= m - 1)
+				result = sols[p][static_cast<uint>(std::countr_zero(m))] < 2;
+		});
+		return result;
 	}
 
-	void accept( bool estimate = false, Difficulty difficulty = Difficulty::Any )
+	// the same search enumerating all the solutions; the subtrees that cannot change any of the counts are skipped
+	bool tally( Trail &t, Counts &sols, const SudokuBits &area, uint64_t &nodes )
 	{
-		for (Cell &c: *this)
-			c.immutable = c.num != 0;
+		uint mark = t.top;
+		bool result = true;
 
-		if (difficulty != Difficulty::Any)
-			Sudoku::level = difficulty;
+		if (SudokuBoard::singles(t) && SudokuBoard::open(sols, area))
+		{
+			uint p = SudokuBoard::choose();
+			if (nodes-- == 0)
+			{
+				result = false;
+			}
+			else
+			if (p == 81)
+			{
+				area.for_each([this, &sols]( uint q )
+				{
+					uint8_t &n = sols[q][SudokuBoard::at(q).num];
+					if (n < 2) n++;
+				});
+			}
+			else
+			{
+				for (uint m = SudokuBoard::at(p).mask(); m != 0 && result; m &= m - 1)
+				{
+					uint q = t.top;
+					SudokuBoard::assign(t, p, static_cast<uint>(std::countr_zero(m)));
+					result = SudokuBoard::tally(t, sols, area, nodes);
+					SudokuBoard::revert(t, q);
+				}
+			}
+		}
 
-		Sudoku::specify_layout(estimate);
-		Sudoku::mem.clear();
+		SudokuBoard::revert(t, mark);
+		return result;
 	}
 
-	void init( std::basic_string<TCHAR> txt )
+	// singles at every node, then branch on the most constrained cell; the board is restored from the trail
+	uint propagate( Trail &t, uint limit )
 	{
-		Sudoku::clear();
+		uint mark = t.top;
+		uint result = 0;
 
-		for (Cell &c: *this)
+		if (SudokuBoard::singles(t))
 		{
-			if (c.pos < txt.size())
+			uint p = SudokuBoard::choose();
+			if (p == 81)
 			{
-				int x = txt[c.pos] - _T('0');
-				c.set(x >= 0 && x <= 9 ? static_cast<uint>(x) : 0U);
+				if (t.found++ == 0)
+					for (SudokuCell &c: *this)
+						t.grid[c.pos] = static_cast<uint8_t>(c.num);
+				result = 1;
+			}
+			else
+			{
+				for (uint m = SudokuBoard::at(p).mask(); m != 0 && result < limit; m &= m - 1)
+				{
+					uint q = t.top;
+					SudokuBoard::assign(t, p, static_cast<uint>(std::countr_zero(m)));
+					result += SudokuBoard::propagate(t, limit - result);
+					SudokuBoard::revert(t, q);
+				}
 			}
 		}
 
-		Sudoku::accept();
+		SudokuBoard::revert(t, mark);
+		return result;
+	}
 
-		for (Cell &c: *this)
+public:
+
+	// resumable constraint propagation search: the state lives in a preallocated stack, so the search
+	// can be run for a number of nodes, paused and resumed later; while paused, the board holds the
+	// partial layout of the search and must not be changed; the board is restored when the search ends
+	class Search
+	{
+		struct Frame
 		{
-			if (c.pos < txt.size())
+			uint8_t  pos;    // branch cell
+			uint16_t mask;   // values not tried yet
+			uint8_t  mark;   // trail position before the singles of the node
+			uint8_t  branch; // trail position before the branch value
+		};
+
+		SudokuBoard &tab;
+		Trail trail;
+		std::array<Frame, 81> stack;
+		uint depth;
+		uint limit;
+		bool descend;
+		bool finished;
+
+	public:
+
+		uint64_t nodes;
+
+		Search( SudokuBoard &_t, uint _l = 1 ): tab{_t}, trail{}, stack{}, depth{0}, limit{_l}, descend{true}, finished{_l == 0 || _t.dup != 0}, nodes{0} {}
+		~Search() { Search::cancel(); }
+
+		Search( const Search & ) = delete;
+		Search &operator=( const Search & ) = delete;
+
+		// run the search for at most 'budget' nodes; true if the search is finished
+		bool run( uint64_t budget = UINT64_MAX )
+		{
+			while (!Search::finished)
 			{
-				int x = txt[c.pos] - _T('@');
-				c.set(x >= 0 && x <= 9 ? static_cast<uint>(x) : 0U);
+				if (Search::descend)
+				{
+					if (budget-- == 0)
+						return false;
+
+					Search::nodes++;
+					Search::descend = false;
+
+					uint mark = Search::trail.top;
+					if (!Search::tab.singles(Search::trail))
+					{
+						Search::tab.revert(Search::trail, mark);
+						continue;
+					}
+
+					uint p = Search::tab.choose();
+					if (p == 81)
+					{
+						if (Search::trail.found++ == 0)
+							for (SudokuCell &c: Search::tab)
+								Search::trail.grid[c.pos] = static_cast<uint8_t>(c.num);
+						Search::tab.revert(Search::trail, mark);
+						continue;
+					}
+
+					Search::stack[Search::depth++] = { static_cast<uint8_t>(p), static_cast<uint16_t>(Search::tab.at(p).mask()), static_cast<uint8_t>(mark), static_cast<uint8_t>(Search::trail.top) };
+				}
+				else
+				if (Search::depth == 0)
+				{
+					Search::finished = true;
+				}
+				else
+				{
+					Frame &f = Search::stack[Search::depth - 1];
+					Search::tab.revert(Search::trail, f.branch);
+					if (f.mask == 0 || Search::trail.found >= Search::limit)
+					{
+						Search::tab.revert(Search::trail, f.mark);
+						Search::depth--;
+						continue;
+					}
+
+					uint v = static_cast<uint>(std::countr_zero(f.mask));
+					f.mask = static_cast<uint16_t>(f.mask & (f.mask - 1));
+					Search::tab.assign(Search::trail, f.pos, v);
+					Search::descend = true;
+				}
 			}
+
+			return true;
 		}
-	}
 
-	void again()
-	{
-		for (Cell &c: *this)
-			if (!c.immutable)
-				c.num = 0;
+		// stop the search and restore the board
+		void cancel()
+		{
+			Search::tab.revert(Search::trail, 0);
+			Search::depth = 0;
+			Search::finished = true;
+		}
 
-		Sudoku::mem.clear();
-	}
+		bool done()      const { return Search::finished; }
+		uint solutions() const { return Search::trail.found; }
 
-private:
+		// value of the cell in the first solution found
+		uint get( uint p ) const { return Search::trail.grid[p]; }
+	};
 
-	void swap_cells( uint p1, uint p2 )
-	{
-		std::swap(Sudoku::at(p1).num,       Sudoku::at(p2).num);
-		std::swap(Sudoku::at(p1).immutable, Sudoku::at(p2).immutable);
-	}
+protected:
 
-	void swap_rows( uint r1, uint r2 )
+	uint64_t key() const { return SudokuBoard::zob; }
+
+	static
+	SudokuDLX &dlx()
 	{
-		r1 *= 9; r2 *= 9;
-		for (uint c = 0; c < 9; c++)
-			Sudoku::swap_cells(r1 + c, r2 + c);
+		static thread_local SudokuDLX dlx{};
+		return dlx;
 	}
 
-	void swap_cols( uint c1, uint c2 )
+public:
+
+	Engine engine{Engine::Backtracking};
+
+	SudokuBoard()
 	{
-		for (uint r = 0; r < 81; r += 9)
-			Sudoku::swap_cells(r + c1, r + c2);
+		SudokuBoard::len.fill(9);
+		SudokuBoard::rng.fill(9 * 20);
+		SudokuBoard::lvl[9] = SudokuBits::all();
 	}
 
-	void shuffle()
+	// whether the layout can be solved (the backtracking search starts from the cell p);
+	// if fill, the solution found is left on the board, otherwise the board is not changed
+	template<Engine E>
+	bool find( uint p, bool fill )
 	{
-		uint v[10];
-	 	std::iota(v, v + 10, 0);
-		std::shuffle(v + 1, v + 10, gen);
+		if constexpr (E == Engine::DLX)
+		{
+			SudokuDLX &x = SudokuBoard::dlx();
+			if (x.solve(*this) == 0)
+				return false;
 
-		for (Cell &c: *this)
-			c.num = v[c.num];
+			if (fill)
+				for (SudokuCell &c: *this)
+					c.put(x.get(c.pos));
 
-		for (uint i = 0; i < 81; i++)
+			return true;
+		}
+		else
+		if constexpr (E == Engine::Propagation)
 		{
-			uint c1 = ::random(9);
-			uint c2 = 3 * (c1 / 3) + (c1 + 1) % 3;
-			Sudoku::swap_cols(c1, c2);
+			Trail t{};
+			if (SudokuBoard::dup != 0 || SudokuBoard::propagate(t, 1) == 0)
+				return false;
+
+			if (fill)
+				for (SudokuCell &c: *this)
+					c.put(t.grid[c.pos]);
 
-			uint r1 = ::random(9);
-			uint r2 = 3 * (r1 / 3) + (r1 + 1) % 3;
-			Sudoku::swap_rows(r1, r2);
+			return true;
+		}
+		else
+		if constexpr (E == Engine::Iterative)
+		{
+			auto x = Search(*this);
+			if (!x.run() || x.solutions() == 0)
+				return false;
 
-			c1 = ::random(3);
-			c2 = (c1 + 1) % 3;
-			c1 *= 3; c2 *= 3;
-			for (uint j = 0; j < 3; j++)
-				Sudoku::swap_cols(c1 + j, c2 + j);
+			if (fill)
+				for (SudokuCell &c: *this)
+					c.put(x.get(c.pos));
 
-			r1 = ::random(3);
-			r2 = (r1 + 1) % 3;
-			r1 *= 3; r2 *= 3;
-			for (uint j = 0; j < 3; j++)
-				Sudoku::swap_rows(r1 + j, r2 + j);
+			return true;
+		}
+		else
+		{
+			return SudokuBoard::at(p).solve(!fill);
 		}
 	}
 
-	int solvable()
+	bool find( uint p, bool fill )
 	{
-		if (Sudoku::corrupt())
-			return -2;
-
-		auto tmp = Sudoku::Temp(this);
-		Sudoku::clear(false);
+		switch (SudokuBoard::engine)
+		{
+		case Engine::DLX:         return SudokuBoard::find<Engine::DLX>(p, fill);
+		case Engine::Propagation: return SudokuBoard::find<Engine::Propagation>(p, fill);
+		case Engine::Iterative:   return SudokuBoard::find<Engine::Iterative>(p, fill);
+		default:                  return SudokuBoard::find<Engine::Backtracking>(p, fill);
+		}
+	}
 
-		if (!tmp.reset())
-			return -2;
+	// number of solutions of the layout, the search stops as soon as the limit is reached; the board is not changed
+	template<Engine E>
+	uint count_solutions( uint limit = 2 )
+	{
+		if (SudokuBoard::dup != 0 || limit == 0)
+			return 0;
 
-		return 0;
+		if constexpr (E == Engine::DLX)
+			return SudokuBoard::dlx().solve(*this, limit);
+		else
+		if constexpr (E == Engine::Propagation)
+		{
+			Trail t{};
+			return SudokuBoard::propagate(t, limit);
+		}
+		else
+		if constexpr (E == Engine::Iterative)
+		{
+			auto x = Search(*this, limit);
+			x.run();
+			return x.solutions();
+		}
+		else
+			return SudokuBoard::backtrack(limit);
 	}
 
-	int correct()
+	uint count_solutions( uint limit = 2 )
 	{
-		auto tmp = Sudoku::Temp(this);
-
-		std::max_element(Sudoku::begin(), Sudoku::end(), Cell::by_length)->solve();
-		if (!Sudoku::solved())
-			return -2;
+		switch (SudokuBoard::engine)
+		{
+		case Engine::DLX:         return SudokuBoard::count_solutions<Engine::DLX>(limit);
+		case Engine::Propagation: return SudokuBoard::count_solutions<Engine::Propagation>(limit);
+		case Engine::Iterative:   return SudokuBoard::count_solutions<Engine::Iterative>(limit);
+		default:                  return SudokuBoard::count_solutions<Engine::Backtracking>(limit);
+		}
+	}
 
-		if (!std::all_of(Sudoku::begin(), Sudoku::end(), [this]( Cell &c ){ return c.generate(Sudoku::level, true) != c.immutable; }))
-			return -1;
+	// for every empty cell of the area and every value: number of the solutions of the layout with the value
+	// in the cell (0, 1 or 2: more than one); false if the search ran out of nodes, then only the counts
+	// equal to 2 are certain; the board is not changed
+	bool count_solutions( Counts &sols, const SudokuBits &area, uint64_t nodes = UINT64_MAX )
+	{
+		sols = Counts{};
+		if (SudokuBoard::dup != 0)
+			return true;
 
-		return 0;
+		Trail t{};
+		return SudokuBoard::tally(t, sols, area, nodes);
 	}
 
-	bool simplify( bool confirm = false )
+	// the most constrained empty cell of the area: the shortest one, then the one with the smallest range,
+	// then the first one (the same choice as std::min_element with SudokuCell::by_length); 81 if there is none
+	uint choose( const SudokuBits &area = SudokuBits::all() )
 	{
-		bool result = false;
-
-		bool simplified;
-		do
+		for (const SudokuBits &l: SudokuBoard::lvl)
 		{
-			simplified = false;
-			for (Cell &c: *this)
+			SudokuBits bits = l & area;
+			if (bits.any())
 			{
-				if (c.num == 0 && (c.num = c.sure(0)) != 0)
+				uint result = 81;
+				bits.for_each([this, &result]( uint p )
 				{
-					if (confirm)
-						c.immutable = true;
-					result = simplified = true;
-				}
+					if (result == 81 || SudokuBoard::rng[p] < SudokuBoard::rng[result])
+						result = p;
+				});
+				return result;
 			}
 		}
-		while (simplified);
-
-		if (confirm)
-		{
-			Sudoku::level = Difficulty::Expert;
-			Sudoku::rating = 0;
-			Sudoku::signature = 0;
-		}
 
-		return result;
+		return 81;
 	}
+};
+
+static_assert(std::is_trivially_copyable_v<SudokuBoard>);
+
+inline constexpr
+SudokuBoard::Keys SudokuBoard::keys = SudokuBoard::zobrist();
+
+SudokuBoard &SudokuCell::tab()
+{
+	return *static_cast<SudokuBoard *>(reinterpret_cast<cell_array *>(this - Cell::pos));
+}
 
-	int weight()
+uint SudokuCell::mask()
+{
+	return ~Cell::tab().used(Cell::pos) & 0x3FE;
+}
+
+void SudokuCell::put( uint n )
+{
+	if (Cell::num != n)
+		Cell::tab().put(Cell::pos, n);
+}
+
+uint SudokuCell::len()
+{
+	return Cell::tab().len[Cell::pos];
+}
+
+uint SudokuCell::range()
+{
+	return Cell::tab().rng[Cell::pos];
+}
+
+bool SudokuCell::repeated()
+{
+	return Cell::num != 0 && Cell::tab().repeated(Cell::pos, Cell::num);
+}
+
+bool SudokuCell::solve( bool check )
+{
+	SudokuBoard &tab = Cell::tab();
+	uint p = tab.choose(SudokuLinks::table.bits[Cell::pos]);
+	if (p == 81)
 	{
-		return Sudoku::rating - static_cast<int>(Sudoku::len()) * 25;
+		p = tab.choose();
+		if (p == 81)
+			return true;
+	}
+
+	Cell &cell = tab[p];
+	for (uint v: Cell::Values(cell, &tab.rnd))
+	{
+		if (v != 0 && (cell.put(v), cell.solve(check)))
+		{
+			if (check)
+				cell.put(0);
+
+			return true;
+		}
+	}
+
+	cell.put(0);
+	return false;
+}
+
+bool SudokuCell::generate( Difficulty level, bool check )
+{
+	if (Cell::num == 0 || Cell::immutable)
+		return false;
+
+	uint n = Cell::num;
+
+	Cell::put(0);
+	if (Cell::sure(n))
+		return true;
+
+	Cell::put(n);
+	if (level == Difficulty::Easy && !check)
+		return false;
+
+	for (uint v: Cell::Values(*this))
+	{
+		if (v != 0 && (Cell::put(v), Cell::tab().find(Cell::pos, false)))
+		{
+			Cell::put(n);
+			return false;
+		}
+	}
+
+	Cell::put(0);
+	return true;
+}
+
+class Sudoku: public SudokuBoard
+{
+	using Cell = SudokuCell;
+
+	static const
+	std::vector<std::basic_string<TCHAR>> extreme;
+
+	static const
+	std::basic_string<TCHAR> html;
+
+	std::list<std::pair<uint, uint>> mem; // position and previous value of the changed cell
+
+	class Backup: public std::array<std::tuple<Cell *, uint, bool>, 81>
+	{
+	public:
+
+		Backup( cell_array *tab )
+		{
+			std::transform(std::begin(*tab), std::end(*tab), Backup::begin(), []( Cell &c )
+			{
+				return std::make_tuple(&c, c.num, c.immutable);
+			});
+		}
+
+		void reload()
+		{
+			std::for_each(Backup::begin(), Backup::end(), []( std::tuple<Cell *, uint, bool> &t )
+			{
+				Cell *c = std::get<Cell *>(t);
+				std::get<uint>(t) = c->num;
+				std::get<bool>(t) = c->immutable;
+			});
+		}
+
+		void restore()
+		{
+			std::for_each(Backup::begin(), Backup::end(), []( std::tuple<Cell *, uint, bool> &t )
+			{
+				Cell *c = std::get<Cell *>(t);
+				c->put(std::get<uint>(t));
+				c->immutable = std::get<bool>(t);
+			});
+		}
+
+		bool changed()
+		{
+			return std::any_of(Backup::begin(), Backup::end(), []( std::tuple<Cell *, uint, bool> &t )
+			{
+				Cell *c = std::get<Cell *>(t);
+				return c->num != std::get<uint>(t);
+			});
+		}
+
+		uint len()
+		{
+			return std::count_if(Backup::begin(), Backup::end(), []( std::tuple<Cell *, uint, bool> &t )
+			{
+				return std::get<uint>(t) != 0;
+			});
+		}
+	};
+
+	class Temp: public Sudoku::Backup
+	{
+	public:
+
+		Temp( cell_array *tab ): Sudoku::Backup(tab) {}
+		~Temp() { Sudoku::Backup::restore(); }
+
+		bool reset()
+		{
+			return std::all_of(Sudoku::Backup::begin(), Sudoku::Backup::end(), []( std::tuple<Cell *, uint, bool> &t )
+			{
+				Cell *c = std::get<Cell *>(t);
+				return c->set(std::get<uint>(t));
+			});
+		}
+	};
+
+	class Random: public std::vector<cell_ref>
+	{
+	public:
+
+		Random( SudokuBoard *tab ): std::vector<cell_ref>(std::begin(*tab), std::end(*tab)), rnd{&tab->rnd}
+		{
+			std::shuffle(Random::begin(), Random::end(), *Random::rnd);
+		}
+
+		Cell& operator()()
+		{
+			return Random::at(Random::rnd->below(static_cast<uint>(Random::size())));
+		}
+
+	private:
+
+		SudokuRandom *rnd;
+	};
+
+	class Sorted: public std::vector<cell_ref>
+	{
+	public:
+
+		Sorted( cell_array *tab, bool(*compare)(Cell &, Cell&) ): std::vector<cell_ref>(std::begin(*tab), std::end(*tab))
+		{
+			std::sort(Sorted::begin(), Sorted::end(), compare);
+		}
+	};
+
+public:
+
+	// ratings of the partial layouts already parsed, keyed by the Zobrist hash of the filled cells;
+	// two-way buckets, the most recent entry comes first and the older one is replaced
+	class Memo
+	{
+		struct Entry
+		{
+			uint64_t key;
+			int      value;
+			bool     used;
+		};
+
+		std::vector<Entry> tab;
+		uint shift;
+
+		size_t slot( uint64_t key ) const
+		{
+			return static_cast<size_t>(key >> Memo::shift) * 2;
+		}
+
+	public:
+
+		uint64_t hits{0};
+		uint64_t misses{0};
+
+		// 2^bits buckets of two entries
+		Memo( uint bits = 18 ): tab(size_t{2} << bits, Entry{0, 0, false}), shift{64 - bits} {}
+
+		bool find( uint64_t key, int &value )
+		{
+			size_t i = Memo::slot(key);
+			for (size_t j = i; j < i + 2; j++)
+			{
+				if (Memo::tab[j].used && Memo::tab[j].key == key)
+				{
+					value = Memo::tab[j].value;
+					Memo::hits++;
+					return true;
+				}
+			}
+			Memo::misses++;
+			return false;
+		}
+
+		void store( uint64_t key, int value )
+		{
+			size_t i = Memo::slot(key);
+			if (!Memo::tab[i].used || Memo::tab[i].key != key)
+				Memo::tab[i + 1] = Memo::tab[i];
+			Memo::tab[i] = Entry{key, value, true};
+		}
+
+		void clear()
+		{
+			std::fill(Memo::tab.begin(), Memo::tab.end(), Entry{0, 0, false});
+			Memo::hits = Memo::misses = 0;
+		}
+	};
+
+	// limits of a single rating by the search grader; zero means no limit
+	struct Budget
+	{
+		uint64_t nodes{0};  // layouts parsed
+		uint     ms{0};     // milliseconds
+	};
+
+	// the workers rate the branches of the first fork only, so their tables are smaller
+	static
+	Memo &memo()
+	{
+		static thread_local Memo memo{SudokuWorkers::inside() ? 16U : 18U};
+		return memo;
+	}
+
+	// the threads of the parallel rating and raise, shared by all the boards
+	static
+	SudokuWorkers &workers()
+	{
+		static SudokuWorkers workers{};
+		return workers;
+	}
+
+	// logical grade of the current layout
+	SudokuLogic::Grade grade()
+	{
+		static thread_local SudokuLogic logic{};
+		return logic.grade(*this);
+	}
+
+	Difficulty level;
+	int        rating;    // lower bound of the rating, if truncated
+	int        upper;     // upper bound of the rating (INT_MAX: unknown)
+	bool       truncated; // the budget ran out before the rating was complete
+	uint32_t   signature;
+	uint64_t   digest;    // wide signature: 64-bit hash of the givens
+	uint       jobs{1};   // threads used by the rating
+	Grader     grader{Grader::Search};
+	Budget     budget{};
+	bool       pooled{false};   // every level (not only Extreme) is drawn from the pool, if it has boards of the level
+	int        target{INT_MIN}; // weight of interest: a rating reaching it is truncated until the board passes the test
+
+	static bool castagnoli; // signatures by CRC-32C (accelerated), the default CRC-32 keeps the ones of the existing board files
+	static std::basic_string<TCHAR> pool_file; // read at the first draw from the pool, so it must be set before
+
+	Sudoku( Difficulty l = Difficulty::Easy ): mem{}, level{l}, rating{0}, upper{0}, truncated{false}, signature{0}, digest{0}
+	{
+		for (Cell &cell: *this)
+		{
+			auto pos = &cell - this->cell_array::data();
+			cell.init(static_cast<uint>(pos));
+		}
+	}
+
+	uint len()
+	{
+		return std::count_if(Sudoku::begin(), Sudoku::end(), []( Cell &c ){ return c.num != 0; });
+	}
+
+	uint count( uint n )
+	{
+		return std::count_if(Sudoku::begin(), Sudoku::end(), [n]( Cell &c ){ return c.num == n; });
+	}
+
+	bool empty()
+	{
+		return std::all_of(Sudoku::begin(), Sudoku::end(), []( Cell &c ){ return c.empty(); });
+	}
+
+	bool corrupt()
+	{
+		for (auto i = Sudoku::begin(); i != Sudoku::end(); i += 9)
+			for (uint n = 1; n <= 9; ++n)
+				if (std::none_of(i, i + 9, [n]( Cell &c ){ return c.accept(n); }))
+					return true;
+
+		return std::any_of(Sudoku::begin(), Sudoku::end(), []( Cell &c ){ return c.corrupt(); });
+	}
+
+	bool solved()
+	{
+		return std::none_of(Sudoku::begin(), Sudoku::end(), []( Cell &c ){ return c.empty() || c.corrupt(); });
+	}
+
+	bool set( Cell *cell, uint n, Force force = Force::Direct )
+	{
+		if (cell == nullptr)
+			return false;
+
+		uint t = cell->num;
+
+		if (t == n)
+			return false;
+
+		switch (force)
+		{
+		case Force::Direct:
+			if (cell->immutable)
+				return false;
+			cell->put(n);
+			break;
+		case Force::Careful:
+			if (!cell->passable(n))
+				return false;
+			cell->put(n);
+			break;
+		case Force::Safe:
+			if (!cell->set(n))
+				return false;
+			break;
+		}
+
+		Sudoku::mem.emplace_back(cell->pos, t);
+		Sudoku::rating = 0;
+		return true;
+	}
+
+	void clear( bool deep = true )
+	{
+		for (Cell &c: *this)
+			c.clear();
+
+		if (deep)
+		{
+			Sudoku::rating = 0;
+			Sudoku::signature = 0;
+			Sudoku::digest = 0;
+			if (Sudoku::level > Difficulty::Easy && Sudoku::level < Difficulty::Extreme)
+				Sudoku::level = Difficulty::Medium;
+		}
+	}
+
+	void discard()
+	{
+		for (Cell &c: *this)
+			c.immutable = false;
+	}
+
+	void accept( bool estimate = false, Difficulty difficulty = Difficulty::Any )
+	{
+		for (Cell &c: *this)
+			c.immutable = c.num != 0;
+
+		if (difficulty != Difficulty::Any)
+			Sudoku::level = difficulty;
+
+		Sudoku::specify_layout(estimate);
+		Sudoku::mem.clear();
+	}
+
+	void init( std::basic_string<TCHAR> txt )
+	{
+		Sudoku::clear();
+
+		for (Cell &c: *this)
+		{
+			if (c.pos < txt.size())
+			{
+				int x = txt[c.pos] - _T('0');
+				c.set(x >= 0 && x <= 9 ? static_cast<uint>(x) : 0U);
+			}
+		}
+
+		Sudoku::accept();
+
+		for (Cell &c: *this)
+		{
+			if (c.pos < txt.size())
+			{
+				int x = txt[c.pos] - _T('@');
+				c.set(x >= 0 && x <= 9 ? static_cast<uint>(x) : 0U);
+			}
+		}
+	}
+
+	// a board of the pool, with its level and rating (nothing is rated again); false if the record is not valid
+	bool init( const SudokuPool::Record &r )
+	{
+		if (!r.valid())
+			return false;
+
+		Sudoku::clear();
+
+		for (Cell &c: *this)
+		{
+			c.put(r.get(c.pos));
+			c.immutable = c.num != 0;
+		}
+
+		Sudoku::level = static_cast<Difficulty>(r.level);
+		Sudoku::truncated = false;
+		Sudoku::upper = Sudoku::rating = r.rating;
+		Sudoku::calculate_signature();
+		Sudoku::mem.clear();
+		return true;
+	}
+
+	SudokuPool::Record record()
+	{
+		SudokuPool::Record r{};
+		for (Cell &c: *this)
+			r.set(c.pos, c.num);
+		r.level  = static_cast<uint8_t>(Sudoku::level);
+		r.len    = static_cast<uint16_t>(Sudoku::len());
+		r.rating = Sudoku::rating;
+		return r;
+	}
+
+	// the pool of boards, mapped from the pool file (if there is one) at the first use
+	static SudokuPool &pool()
+	{
+		static SudokuPool pool{Sudoku::pool_file.c_str()};
+		return pool;
+	}
+
+	void again()
+	{
+		for (Cell &c: *this)
+			if (!c.immutable)
+				c.put(0);
+
+		Sudoku::mem.clear();
+	}
+
+private:
+
+	void shuffle()
+	{
+		Sudoku::transform(Sudoku::symmetry());
+	}
+
+public:
+
+	// an element of the symmetry group of the board (relabeling of the digits, order of the bands, of the
+	// rows within a band, of the stacks, of the columns within a stack, transposition) composed into one
+	// permutation of the cells: the cell p takes the relabeled digit of the cell map[p]
+	struct Symmetry
+	{
+		std::array<uint8_t, 81> map;
+		std::array<uint8_t, 10> dig;
+	};
+
+	// a random element of the symmetry group, every element equally likely
+	Symmetry symmetry()
+	{
+		auto lines = [this]( uint8_t *x )
+		{
+			uint8_t band[3] = { 0, 1, 2 };
+			std::shuffle(band, band + 3, Sudoku::rnd);
+			for (uint b = 0; b < 3; b++)
+			{
+				uint8_t line[3] = { 0, 1, 2 };
+				std::shuffle(line, line + 3, Sudoku::rnd);
+				for (uint i = 0; i < 3; i++)
+					x[b * 3 + i] = static_cast<uint8_t>(band[b] * 3 + line[i]);
+			}
+		};
+
+		uint8_t row[9], col[9];
+		lines(row);
+		lines(col);
+		bool t = Sudoku::rnd.below(2) != 0;
+
+		Symmetry s;
+		std::iota(s.dig.begin(), s.dig.end(), static_cast<uint8_t>(0));
+		std::shuffle(s.dig.begin() + 1, s.dig.end(), Sudoku::rnd);
+		for (uint r = 0; r < 9; r++)
+			for (uint c = 0; c < 9; c++)
+				s.map[r * 9 + c] = static_cast<uint8_t>(t ? col[c] * 9 + row[r] : row[r] * 9 + col[c]);
+		return s;
+	}
+
+	// the layout (with its immutable cells) transformed in one pass; the rating, the level
+	// and the signature are the invariants of the transformation, so they are kept,
+	// only the wide signature follows the layout
+	void transform( const Symmetry &s )
+	{
+		std::array<uint8_t, 81> num;
+		std::array<bool, 81>    imm;
+		for (Cell &c: *this)
+		{
+			num[c.pos] = static_cast<uint8_t>(c.num);
+			imm[c.pos] = c.immutable;
+		}
+
+		for (Cell &c: *this)
+		{
+			c.put(s.dig[num[s.map[c.pos]]]);
+			c.immutable = imm[s.map[c.pos]];
+		}
+
+		if (Sudoku::signature != 0)
+			Sudoku::calculate_digest();
+		Sudoku::mem.clear();
+	}
+
+	// the built-in extreme boards, the seeds of the isomorphs
+	static const std::vector<std::basic_string<TCHAR>> &extremes() { return Sudoku::extreme; }
+
+	// k different isomorphs of the layout drawn at random (fewer only if the draws keep repeating)
+	std::vector<Sudoku> isomorphs( uint k )
+	{
+		auto result = std::vector<Sudoku>();
+		auto seen   = std::set<std::array<uint8_t, 81>>();
+
+		for (uint miss = 0; result.size() < k && miss < 64; )
+		{
+			auto tmp = *this;
+			tmp.transform(Sudoku::symmetry());
+
+			std::array<uint8_t, 81> key;
+			for (Cell &c: tmp)
+				key[c.pos] = static_cast<uint8_t>(c.num);
+
+			if (!seen.insert(key).second)
+			{
+				miss++;
+				continue;
+			}
+
+			result.push_back(tmp);
+			miss = 0;
+		}
+
+		return result;
+	}
+
+private:
+
+	int solvable()
+	{
+		if (Sudoku::corrupt())
+			return -2;
+
+		auto tmp = Sudoku::Temp(this);
+		Sudoku::clear(false);
+
+		if (!tmp.reset())
+			return -2;
+
+		return 0;
+	}
+
+	int correct()
+	{
+		switch (Sudoku::count_solutions(2))
+		{
+		case 0:  return -2;
+		case 1:  return  0;
+		default: return -1;
+		}
+	}
+
+	bool simplify( bool confirm = false )
+	{
+		bool result = false;
+
+		bool simplified;
+		do
+		{
+			simplified = false;
+			for (Cell &c: *this)
+			{
+				if (c.num == 0 && (c.put(c.sure(0)), c.num != 0))
+				{
+					if (confirm)
+						c.immutable = true;
+					result = simplified = true;
+				}
+			}
+		}
+		while (simplified);
+
+		if (confirm)
+		{
+			Sudoku::level = Difficulty::Expert;
+			Sudoku::rating = 0;
+			Sudoku::signature = 0;
+			Sudoku::digest = 0;
+		}
+
+		return result;
+	}
+
+	// weight of the rating or of its upper bound
+	int weight( bool bound = false )
+	{
+		int r = bound ? Sudoku::upper : Sudoku::rating;
+		if (r == INT_MAX)
+			return INT_MAX;
+		return r - static_cast<int>(Sudoku::len()) * 25;
+	}
+
+public:
+
+	template<Engine E>
+	void solve()
+	{
+		if (Sudoku::solvable() == 0)
+		{
+			Sudoku::find<E>(std::max_element(Sudoku::begin(), Sudoku::end(), Cell::by_length)->pos, true);
+			Sudoku::mem.clear();
+		}
+	}
+
+	void solve()
+	{
+		switch (Sudoku::engine)
+		{
+		case Engine::DLX:         Sudoku::solve<Engine::DLX>();          break;
+		case Engine::Propagation: Sudoku::solve<Engine::Propagation>();  break;
+		case Engine::Iterative:   Sudoku::solve<Engine::Iterative>();    break;
+		default:                  Sudoku::solve<Engine::Backtracking>(); break;
+		}
+	}
+
+	void generate( Difficulty difficulty = Difficulty::Any )
+	{
+		if (difficulty != Difficulty::Any)
+			Sudoku::level = difficulty;
+
+		if (Sudoku::level == Difficulty::Extreme || Sudoku::pooled)
+		{
+			auto &p = Sudoku::pool();
+			auto  n = std::min(p.size(static_cast<uint>(Sudoku::level)), static_cast<size_t>(UINT_MAX));
+			if (n > 0 && Sudoku::init(p.begin(static_cast<uint>(Sudoku::level))[Sudoku::rnd.below(static_cast<uint>(n))]))
+			{
+				Sudoku::shuffle();
+				return;
+			}
+		}
+
+		if (Sudoku::level == Difficulty::Extreme)
+		{
+			Sudoku::init(Sudoku::extreme[Sudoku::rnd.below(static_cast<uint>(Sudoku::extreme.size()))]);
+			Sudoku::shuffle();
+		}
+		else
+		{
+			auto lst = Sudoku::Random(this);
+			Sudoku::clear();
+			lst().solve();
+			for (Cell &c: lst)
+				c.generate(Sudoku::level);
+			Sudoku::accept();
+		}
+	}
+
+	// the layout (and the state) of the copy, but not its random stream, so that the stream is not replayed
+	void restore( const Sudoku &sudoku )
+	{
+		auto r = Sudoku::rnd;
+		*this = sudoku;
+		Sudoku::rnd = r;
+	}
+
+	// count: number of the solutions of the layout (2: more than one), if already known (UINT_MAX otherwise);
+	// a layout with other than one solution is rejected at once, otherwise it is accept(true) without the solver
+	bool verify( bool forced, uint count = UINT_MAX )
+	{
+		if (count != UINT_MAX && count != 1)
+			return false;
+
+		Difficulty current = Sudoku::level;
+		if (count == 1)
+		{
+			for (Cell &c: *this)
+				c.immutable = c.num != 0;
+
+			Sudoku::truncated = false;
+			Sudoku::upper = Sudoku::rating = 0;
+			Sudoku::calculate_level();
+			Sudoku::calculate_signature(true);
+			Sudoku::mem.clear();
+		}
+		else
+			Sudoku::accept(true);
+
+		if (Sudoku::rating >= 0 && (!forced || (Sudoku::level >= current && Sudoku::level >= Difficulty::Hard)))
+		{
+			if (forced && Sudoku::level == Difficulty::Hard && Sudoku::level > current)
+				Sudoku::simplify(true);
+			return true;
+		}
+		Sudoku::level = current;
+		return false;
+	}
+
+	// ci and cj were cleared: fill one empty cell (ci, cj or linked to them, taken in the given order)
+	// so that the layout stays correct and passes verify; false if there is no such cell
+	bool refill( Cell &ci, Cell &cj, const std::vector<cell_ref> &order, bool forced )
+	{
+		// every layout tried below is this one with a single cell filled, so the solutions
+		// of this layout are enumerated once instead of solving every one of them
+		auto area = SudokuBits();
+		for (Cell &c: *this)
+			if (c.num == 0 && (&c == &ci || &c == &cj || c.linked(&ci) || c.linked(&cj)))
+				area.set(c.pos);
+		auto sols  = Counts{};
+		bool known = Sudoku::count_solutions(sols, area, 1U << 20);
+
+		for (const Cell &o: order)
+		{
+			Cell &cell = Sudoku::at(o.pos);
+			if (cell.num != 0) continue;
+			if (&cell != &ci && &cell != &cj && !cell.linked(&ci) && !cell.linked(&cj)) continue;
+
+			for (uint v: Cell::Values(cell))
+			{
+				if (v == 0)
+					continue;
+
+				uint count = known || sols[cell.pos][v] == 2 ? sols[cell.pos][v] : UINT_MAX;
+				if (cell.put(v), Sudoku::verify(forced, count))
+					return true;
+			}
+
+			cell.put(0);
+		}
+
+		return false;
+	}
+
+	// the pairs (ci, cj) are tried in batches, every pair on its own copy of the board; the random order of
+	// the cells is drawn for all the pairs of the batch before, and the first pair (in the serial order)
+	// that succeeded is committed, so the result depends on the seed only, not on the number of threads
+	// (a single thread takes the same path and tries the pairs of the batch one after another)
+	bool raise_step( std::vector<cell_ref> &vec, bool forced )
+	{
+		auto pairs = std::vector<std::pair<uint, uint>>();
+		for (auto i = vec.begin(); i != vec.end(); ++i)
+			for (auto j = i + 1; j != vec.end(); ++j)
+				if (i->get().num != 0 && j->get().num != 0)
+					pairs.emplace_back(i->get().pos, j->get().pos);
+
+		const size_t batch = 64;
+		for (size_t first = 0; first < pairs.size(); first += batch)
+		{
+			size_t size = std::min(batch, pairs.size() - first);
+			auto order = std::vector<std::vector<cell_ref>>();
+			for (size_t k = 0; k < size; k++)
+				order.emplace_back(Sudoku::Random(this));
+
+			auto board = std::vector<std::optional<Sudoku>>(size);
+			auto found = std::atomic<size_t>{size};
+			auto next  = std::atomic<size_t>{0};
+			auto work  = [this, &pairs, &order, &board, &found, &next, first, size, forced]
+			{
+				for (size_t k = next++; k < size && k < found; k = next++)
+				{
+					auto tmp = *this;
+					Cell &ci = tmp.at(pairs[first + k].first);
+					Cell &cj = tmp.at(pairs[first + k].second);
+					ci.put(0);
+					cj.put(0);
+					if (tmp.refill(ci, cj, order[k], forced))
+					{
+						board[k] = tmp;
+						for (size_t f = found; k < f && !found.compare_exchange_weak(f, k); );
+					}
+				}
+			};
+
+			Sudoku::workers().run(static_cast<uint>(std::min<size_t>(Sudoku::jobs, size)), work);
+
+			if (found < size)
+			{
+				Sudoku::restore(*board[found]);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// a layout of at most n clues with the solution of the current one, searched for ms milliseconds
+	// by hitting the unavoidable sets of the grid; the layout is left unchanged if none was found;
+	// the new layout is not rated, that is left to raise()
+	bool reduce( uint n, uint ms )
+	{
+		if (Sudoku::len() <= n)
+			return false;
+
+		auto tmp = *this;
+		tmp.solve<Engine::Propagation>();
+
+		SudokuHitting::Grid grid;
+		for (Cell &c: tmp)
+			grid[c.pos] = static_cast<uint8_t>(c.num);
+
+		auto hit = SudokuHitting(grid);
+		if (!hit.search(n, ms, static_cast<uint32_t>(Sudoku::rnd()), grid))
+			return false;
+
+		Sudoku::clear();
+		for (Cell &c: *this)
+		{
+			c.put(grid[c.pos]);
+			c.immutable = c.num != 0;
+		}
+		Sudoku::mem.clear();
+		return true;
+	}
+
+	void raise( bool force = true, bool show = true )
+	{
+		Sudoku::accept(false, Difficulty::Medium);
+		if (show)
+			std::cerr << *this << std::endl;
+
+		if (force && Sudoku::level == Difficulty::Hard)
+		{
+			Sudoku::simplify(true);
+			if (show)
+			{
+				if (Sudoku::len() <= 20)
+					accept();
+				std::cerr << *this << std::endl;
+			}
+		}
+
+		bool forced = false;
+		bool success = true;
+		while (success && Sudoku::len() > 17)
+		{
+			forced = forced || (force && (Sudoku::level >= Difficulty::Hard || Sudoku::len() <= 30));
+			success = false;
+			auto vec = Sudoku::Sorted(this, Cell::by_solid);
+			success = Sudoku::raise_step(vec, forced);
+
+			if (success && show)
+			{
+				if (Sudoku::len() <= 20)
+					accept();
+				std::cerr << *this << std::endl;
+			}
+		}
+
+		Sudoku::accept();
+		if (show)
+			std::cerr << *this << std::endl;
+	}
+
+	// statistics of the optimizer, summed over its runs
+	struct Stats
+	{
+		uint64_t runs{0};       // restarts
+		uint64_t found{0};      // runs that reached the target
+		uint64_t moves{0};      // moves tried
+		uint64_t accepted{0};   // moves accepted
+		int      best{INT_MIN}; // best weight seen
+	};
+
+	// simulated annealing over the clue moves: remove a clue, add one, move a clue to a linked cell or remove
+	// two clues and add one linked to them (the move of raise); the added value is any allowed one, a move
+	// leaving other than one solution is undone; the score is the exact weight, less 25 for every level
+	// below Expert; the temperature falls with the time from 25 (a clue) to zero; the run ends as soon as
+	// an Expert layout reaches the goal weight or when the time is up, the best layout is left then;
+	// the chance of the acceptance is drawn before the rating, so a move is rated up to the score it
+	// needs (the target) and only a move reaching it gets the complete rating
+	bool anneal( int goal, uint ms, Stats &stats )
+	{
+		using clock = std::chrono::steady_clock;
+		auto start = clock::now();
+		auto limit = std::chrono::milliseconds(ms);
+
+		stats.runs++;
+		Sudoku::accept(false, Difficulty::Medium);
+		if (Sudoku::rating < 0)
+			return false;
+
+		auto score = []( Sudoku &b ){ return b.weight() - (Difficulty::Expert - b.level) * 25; };
+		auto pick  = [this]( bool full, Cell *a, Cell *b ) -> Cell *
+		{
+			auto lst = std::vector<Cell *>();
+			for (Cell &c: *this)
+				if ((c.num != 0) == full && (a == nullptr || c.linked(a) || (b != nullptr && c.linked(b))))
+					lst.push_back(&c);
+			return lst.empty() ? nullptr : lst[Sudoku::rnd.below(static_cast<uint>(lst.size()))];
+		};
+
+		int  t = Sudoku::target;
+		Sudoku::target = INT_MIN;
+
+		auto best = *this;
+		int  cur  = score(*this);
+		int  top  = cur;
+		bool found = false;
+		for (auto now = clock::now(); !found && now - start < limit; now = clock::now())
+		{
+			double heat = 25.0 * (1.0 - std::chrono::duration<double>(now - start) / limit) + 0.01;
+			auto prev = *this;
+			stats.moves++;
+
+			uint  move = Sudoku::rnd.below(4);
+			Cell *ci = move != 1 ? pick(true, nullptr, nullptr) : nullptr;
+			if (ci != nullptr) ci->put(0);
+			Cell *cj = move == 3 ? pick(true, nullptr, nullptr) : nullptr;
+			if (cj != nullptr) cj->put(0);
+			Cell *ck = move != 0 ? pick(false, ci, cj) : nullptr;
+			auto  v  = std::vector<uint>();
+			if (ck != nullptr)
+				for (uint n: Cell::Values(*ck))
+					if (n != 0)
+						v.push_back(n);
+			if (v.size() > 0)
+				ck->put(v[Sudoku::rnd.below(static_cast<uint>(v.size()))]);
+
+			// a move that cannot be made in full is not tried
+			if ((move != 1 && ci == nullptr) || (move == 3 && cj == nullptr) || (move != 0 && v.empty()) ||
+			    Sudoku::count_solutions(2) != 1)
+			{
+				Sudoku::restore(prev);
+				continue;
+			}
+
+			// accepted: s >= cur or s > bar; the weight of an Expert layout needs at least the target
+			double u   = Sudoku::rnd.real();
+			double bar = u > 0 ? cur + heat * std::log(u) : -HUGE_VAL;
+			Sudoku::target = bar > INT_MIN / 2 ? std::min(cur, static_cast<int>(std::floor(bar)) + 1) : INT_MIN;
+			Sudoku::accept();
+			Sudoku::target = INT_MIN;
+
+			int s = Sudoku::weight(true);
+			if (s != INT_MAX)
+				s -= (Difficulty::Expert - Sudoku::level) * 25;
+			if (s < cur && s <= bar)
+			{
+				Sudoku::restore(prev);
+				continue;
+			}
+
+			if (Sudoku::truncated)
+				Sudoku::complete();
+			s = score(*this);
+			if (s >= cur || s > bar)
+			{
+				cur = s;
+				stats.accepted++;
+				if (cur > top)
+				{
+					top  = cur;
+					best = *this;
+				}
+				found = Sudoku::level >= Difficulty::Expert && Sudoku::weight() >= goal;
+			}
+			else
+				Sudoku::restore(prev);
+		}
+
+		if (!found)
+			Sudoku::restore(best);
+
+		Sudoku::target = t;
+		stats.best = std::max(stats.best, Sudoku::weight());
+		if (found)
+			stats.found++;
+		return found;
+	}
+
+	bool test( bool all )
+	{
+		if (Sudoku::rating == -2)
+		{
+			std::cerr << "ERROR: unsolvable" << std::endl;
+			return false;
+		}
+
+		if (Sudoku::rating == -1)
+		{
+			std::cerr << "ERROR: ambiguous"  << std::endl;
+			return false;
+		}
+
+		if (Sudoku::level == Difficulty::Easy || all || Sudoku::weight() >= 0)
+		{
+			if (Sudoku::truncated && Sudoku::budget.nodes == 0 && Sudoku::budget.ms == 0)
+				Sudoku::complete();
+			return true;
+		}
+
+		// the lower bound is not enough, the upper one could be
+		if (Sudoku::truncated && Sudoku::weight(true) >= 0)
+			std::cerr << "ERROR: rating truncated" << std::endl;
+
+		return false;
+	}
+
+	bool undo()
+	{
+		if (!Sudoku::mem.empty())
+		{
+			Sudoku::at(std::get<0>(Sudoku::mem.back())).put(std::get<1>(Sudoku::mem.back()));
+			Sudoku::mem.pop_back();
+			return false;
+		}
+		else
+		{
+			Sudoku::again();
+			Sudoku::specify_layout();
+			return true;
+		}
+	}
+
+private:
+
+	// the rating depends only on the filled cells, so it is parsed once for every partial layout;
+	// results are exact below the cap, any result reaching the cap is returned as the cap
+	int parse_rating( int cap = INT_MAX )
+	{
+		int result;
+		Memo &m = Sudoku::memo();
+		if (!m.find(Sudoku::key(), result))
+		{
+			result = Sudoku::parse_layout(1, cap);
+			if (result < cap)
+				m.store(Sudoku::key(), result);
+		}
+		return std::min(result, cap);
+	}
+
+	// with more than one job the branches of the first fork are rated in parallel;
+	// a cell whose sum reaches the least one found so far is not parsed any further
+	int parse_layout( uint threads = 1, int cap = INT_MAX )
+	{
+		std::vector<std::pair<Cell *, uint>> sure;
+		for (Cell &c: *this)
+		{
+			if (c.num == 0)
+			{
+				uint n = c.sure();
+				if (n != 0)
+					sure.emplace_back(&c, n);
+				else
+				if (c.len() < 2) // wrong way
+					return 0;
+			}
+		}
+
+		if (!sure.empty())
+		{
+			int  result  = 0;
+			bool success = true;
+			for (std::pair<Cell *, uint> &p: sure)
+				if (!std::get<Cell *>(p)->set(std::get<uint>(p)))
+					success = false;
+			if (success)
+				result = cap > 1 ? (threads > 1 ? Sudoku::parse_layout(threads, cap - 1) : Sudoku::parse_rating(cap - 1)) + 1 : 1;
+			for (std::pair<Cell *, uint> &p: sure)
+				std::get<Cell *>(p)->put(0);
+			return result;
+		}
+			
+		uint p = Sudoku::choose();
+		if (p == 81) // solved!
+			return 1;
+
+		Cell &cell = Sudoku::at(p);
+
+		uint len    = cell.len();
+		uint range  = cell.range();
+		if (cap <= 1)
+			return 1;
+		if (threads > 1)
+			return std::min(Sudoku::parse_fork(len, range, threads), cap - 1) + 1;
+
+		int result = 0;
+		for (Cell &c: *this)
+		{
+			if (c.num == 0 && c.len() == len && c.range() == range)
+			{
+				int r = 0;
+				int k = result == 0 ? cap - 1 : result;
+				for (uint v: Cell::Values(c))
+				{
+					if (r >= k)
+						break;
+					if (v != 0 && c.set(v))
+					{
+						r += Sudoku::parse_rating(k - r);
+						c.put(0);
+					}
+				}
+				if (result == 0 || r < result)
+					result = r;
+			}
+		}
+
+		return result + 1;
 	}
 
-public:
+	// the top of the search tree leads to the solution, so no cell there is a wrong way and the result
+	// is at most the sum of any of its cells; as soon as one of them is below the cap, the cap is
+	// unreachable: the parse stops and returns the upper bound, and the lower bound proved so far
+	// (one for every level above, the levels of the sure cells included) is set in place of zero
+	int parse_goal( int cap, int &lower )
+	{
+		std::vector<std::pair<Cell *, uint>> sure;
+		for (Cell &c: *this)
+		{
+			if (c.num == 0)
+			{
+				uint n = c.sure();
+				if (n != 0)
+					sure.emplace_back(&c, n);
+				else
+				if (c.len() < 2) // wrong way
+					return 0;
+			}
+		}
+
+		if (!sure.empty())
+		{
+			int  result  = 0;
+			bool success = true;
+			for (std::pair<Cell *, uint> &p: sure)
+				if (!std::get<Cell *>(p)->set(std::get<uint>(p)))
+					success = false;
+			if (success)
+				result = cap > 1 ? Sudoku::parse_goal(cap - 1, lower) + 1 : 1;
+			if (lower > 0)
+				lower++;
+			for (std::pair<Cell *, uint> &p: sure)
+				std::get<Cell *>(p)->put(0);
+			return result;
+		}
+
+		uint p = Sudoku::choose();
+		if (p == 81) // solved!
+			return 1;
 
-	void solve()
-	{
-		if (Sudoku::solvable() == 0)
-		{
-			std::max_element(Sudoku::begin(), Sudoku::end(), Cell::by_length)->solve();
-			Sudoku::mem.clear();
-		}
-	}
+		Cell &cell = Sudoku::at(p);
 
-	void generate( Difficulty difficulty = Difficulty::Any )
-	{
-		if (difficulty != Difficulty::Any)
-			Sudoku::level = difficulty;
+		uint len    = cell.len();
+		uint range  = cell.range();
+		if (cap <= 1)
+			return 1;
 
-		if (Sudoku::level == Difficulty::Extreme)
-		{
-			Sudoku::init(Sudoku::extreme[::random(Sudoku::extreme.size())]);
-			Sudoku::shuffle();
-		}
-		else
+		int result = 0;
+		for (Cell &c: *this)
 		{
-			auto rnd = Sudoku::Random(this);
-			Sudoku::clear();
-			rnd().solve();
-			for (Cell &c: rnd)
-				c.generate(Sudoku::level);
-			Sudoku::accept();
+			if (c.num == 0 && c.len() == len && c.range() == range)
+			{
+				int r = 0;
+				int k = result == 0 ? cap - 1 : result;
+				for (uint v: Cell::Values(c))
+				{
+					if (r >= k)
+						break;
+					if (v != 0 && c.set(v))
+					{
+						r += Sudoku::parse_rating(k - r);
+						c.put(0);
+					}
+				}
+				if (result == 0 || r < result)
+					result = r;
+				if (result < cap - 1)
+				{
+					lower = 1;
+					break;
+				}
+			}
 		}
-	}
 
-	bool verify( bool forced )
-	{
-		Difficulty current = Sudoku::level;
-		Sudoku::accept(true);
-		if (Sudoku::rating >= 0 && (!forced || (Sudoku::level >= current && Sudoku::level >= Difficulty::Hard)))
-		{
-			if (forced && Sudoku::level == Difficulty::Hard && Sudoku::level > current)
-				Sudoku::simplify(true);
-			return true;
-		}
-		Sudoku::level = current;
-		return false;
+		return result + 1;
 	}
 
-	void raise( bool force = true, bool show = true )
+	// every branch (cell, value) of the first fork is a task rated on its own copy of the board;
+	// the tasks are taken by the workers as they get free and the ratings
+	// are combined in the serial order, so the result is the same
+	int parse_fork( uint len, uint range, uint threads )
 	{
-		Sudoku::accept(false, Difficulty::Medium);
-		if (show)
-			std::cerr << *this << std::endl;
-
-		if (force && Sudoku::level == Difficulty::Hard)
+		struct Task
 		{
-			Sudoku::simplify(true);
-			if (show)
+			uint cell;
+			uint pos;
+			uint value;
+			int  rating;
+		};
+
+		std::vector<Task> task;
+		uint cells = 0;
+		for (Cell &c: *this)
+		{
+			if (c.num == 0 && c.len() == len && c.range() == range)
 			{
-				if (Sudoku::len() <= 20)
-					accept();
-				std::cerr << *this << std::endl;
+				for (uint v: Cell::Values(c))
+					if (v != 0)
+						task.push_back(Task{cells, c.pos, v, 0});
+				cells++;
 			}
 		}
 
-		bool forced = false;
-		bool success = true;
-		while (success && Sudoku::len() > 17)
+		std::atomic<size_t> next{0};
+		auto work = [this, &task, &next]
 		{
-			forced = forced || (force && (Sudoku::level >= Difficulty::Hard || Sudoku::len() <= 30));
-			success = false;
-			auto vec = Sudoku::Sorted(this, Cell::by_solid);
-			for (auto i = vec.begin(); i != vec.end(); ++i)
+			for (size_t i = next++; i < task.size(); i = next++)
 			{
-				Cell &ci = *i;
-				if (ci.num == 0) continue;
-				uint ni = ci.num;
-				ci.num = 0;
-
-				for (auto j = i + 1; j != vec.end(); ++j)
-				{
-					Cell &cj = *j;
-					if (cj.num == 0) continue;
-					uint nj = cj.num;
-					cj.num = 0;
-
-					for (Cell &cell: Sudoku::Random(this))
-					{
-						if (cell.num != 0) continue;
-						if (&cell != &ci && &cell != &cj && !cell.linked(&ci) && !cell.linked(&cj)) continue;
+				Sudoku tmp = *this;
+				if (tmp.at(task[i].pos).set(task[i].value))
+					task[i].rating = tmp.parse_rating();
+			}
+		};
 
-						for (uint v: Cell::Values(cell))
-						{
-							if ((cell.num = v) != 0 && Sudoku::verify(forced))
-							{
-								if (show)
-								{
-									if (Sudoku::len() <= 20)
-										accept();
-									std::cerr << *this << std::endl;
-								}
-
-								success = true;
-								break;
-							}
-						}
+		Sudoku::workers().run(static_cast<uint>(std::min<size_t>(threads, task.size())), work);
 
-						if (success) break;
-						cell.num = 0;
-					}
+		auto r = std::vector<int>(cells, 0);
+		for (Task &t: task)
+			r[t.cell] += t.rating;
 
-					if (success) break;
-					cj.num = nj;
-				}
+		int result = 0;
+		for (int x: r)
+			if (result == 0 || x < result)
+				result = x;
 
-				if (success) break;
-				ci.num = ni;
-			}
-		}
+		return result;
+	}
 
-		Sudoku::accept();
-		if (show)
-			std::cerr << *this << std::endl;
+	// the rating grows with the size of the search tree
+	int scale_rating( int result )
+	{
+		int msb = 0;
+		int r   = 0;
+		for (uint i = Sudoku::count(0); result > 0; r += static_cast<int>(i--), result >>= 1)
+			msb = (result & 1) ? msb + 1 : 0;
+		return r + msb - 1;
 	}
 
-	bool test( bool all )
+	// possible results of a parse cut by the budget: zero (a wrong way) and / or any value from lo to hi
+	struct Range
 	{
-		if (Sudoku::rating == -2)
+		bool zero;
+		int  lo;
+		int  hi;   // INT_MAX: unknown
+
+		static Range exact( int v ) { return v == 0 ? Range{true, INT_MAX, 0} : Range{false, v, v}; }
+		static Range unknown()      { return Range{true, 1, INT_MAX}; }
+
+		bool empty() const { return lo > hi; }
+		bool known() const { return  zero ? empty() : lo == hi; }
+
+		void join( int l, int h )
 		{
-			std::cerr << "ERROR: unsolvable" << std::endl;
-			return false;
+			Range::lo = std::min(Range::lo, l);
+			Range::hi = std::max(Range::hi, h);
 		}
 
-		if (Sudoku::rating == -1)
+		static int sum( int a, int b ) { return a > INT_MAX - b ? INT_MAX : a + b; }
+
+		// a + b
+		friend Range operator+( const Range &a, const Range &b )
 		{
-			std::cerr << "ERROR: ambiguous"  << std::endl;
-			return false;
+			Range r{a.zero && b.zero, INT_MAX, 0};
+			if (a.zero && !b.empty()) r.join(b.lo, b.hi);
+			if (b.zero && !a.empty()) r.join(a.lo, a.hi);
+			if (!a.empty() && !b.empty()) r.join(Range::sum(a.lo, b.lo), Range::sum(a.hi, b.hi));
+			return r;
 		}
 
-		return Sudoku::level == Difficulty::Easy || all || Sudoku::weight() >= 0;
-	}
+		// a + 1
+		Range next() const
+		{
+			Range r{false, INT_MAX, 0};
+			if (Range::zero) r.join(1, 1);
+			if (!Range::empty()) r.join(Range::sum(Range::lo, 1), Range::sum(Range::hi, 1));
+			return r;
+		}
 
-	bool undo()
-	{
-		if (!Sudoku::mem.empty())
+		// (a == 0 || b < a) ? b : a
+		Range least( const Range &b ) const
 		{
-			std::get<Cell *>(Sudoku::mem.back())->num = std::get<uint>(Sudoku::mem.back());
-			Sudoku::mem.pop_back();
-			return false;
+			Range r{false, INT_MAX, 0};
+			if (Range::zero) { r.zero = b.zero; if (!b.empty()) r.join(b.lo, b.hi); }
+			if (!Range::empty()) { r.zero = r.zero || b.zero; if (!b.empty()) r.join(std::min(Range::lo, b.lo), std::min(Range::hi, b.hi)); }
+			return r;
 		}
-		else
+	};
+
+	// nodes and time left for the rating
+	struct Meter
+	{
+		uint64_t nodes;
+		bool     timed;
+		bool     out{false};
+		std::chrono::steady_clock::time_point deadline;
+
+		Meter( const Budget &b ):
+			nodes{b.nodes ? b.nodes : UINT64_MAX},
+			timed{b.ms != 0},
+			deadline{std::chrono::steady_clock::now() + std::chrono::milliseconds(b.ms)} {}
+
+		bool spend()
 		{
-			Sudoku::again();
-			Sudoku::specify_layout();
-			return true;
+			if (!Meter::out && (Meter::nodes-- == 0 || (Meter::timed && (Meter::nodes & 0xFF) == 0 && std::chrono::steady_clock::now() >= Meter::deadline)))
+				Meter::out = true;
+			return !Meter::out;
 		}
-	}
+	};
 
-private:
+	// parse_layout within the budget; the unparsed subtrees make the result a range,
+	// only the exact results are memoized
+	Range parse_range( Meter &m )
+	{
+		int result;
+		Memo &memo = Sudoku::memo();
+		if (memo.find(Sudoku::key(), result))
+			return Range::exact(result);
+
+		if (!m.spend())
+			return Range::unknown();
+
+		Range range = Sudoku::parse_bounded(m);
+		if (range.known())
+			memo.store(Sudoku::key(), range.zero ? 0 : range.lo);
+		return range;
+	}
 
-	int parse_rating()
+	Range parse_bounded( Meter &m )
 	{
 		std::vector<std::pair<Cell *, uint>> sure;
 		for (Cell &c: *this)
@@ -902,81 +2458,122 @@ private:
 					sure.emplace_back(&c, n);
 				else
 				if (c.len() < 2) // wrong way
-					return 0;
+					return Range::exact(0);
 			}
 		}
 
 		if (!sure.empty())
 		{
-			int  result  = 0;
-			bool success = true;
+			Range result  = Range::exact(0);
+			bool  success = true;
 			for (std::pair<Cell *, uint> &p: sure)
 				if (!std::get<Cell *>(p)->set(std::get<uint>(p)))
 					success = false;
 			if (success)
-				result = Sudoku::parse_rating() + 1;
+				result = Sudoku::parse_range(m).next();
 			for (std::pair<Cell *, uint> &p: sure)
-				std::get<Cell *>(p)->num = 0;
+				std::get<Cell *>(p)->put(0);
 			return result;
 		}
-			
-		Cell &cell = *std::min_element(Sudoku::begin(), Sudoku::end(), Cell::by_length);
-		if (cell.num != 0) // solved!
-			return 1;
+
+		uint p = Sudoku::choose();
+		if (p == 81) // solved!
+			return Range::exact(1);
+
+		Cell &cell = Sudoku::at(p);
 
 		uint len    = cell.len();
 		uint range  = cell.range();
-		int result = 0;
+
+		Range result = Range::exact(0);
 		for (Cell &c: *this)
 		{
 			if (c.num == 0 && c.len() == len && c.range() == range)
 			{
-				int r = 0;
+				Range r = Range::exact(0);
 				for (uint v: Cell::Values(c))
 				{
 					if (v != 0 && c.set(v))
 					{
-						r += Sudoku::parse_rating();
-						c.num = 0;
+						r = r + Sudoku::parse_range(m);
+						c.put(0);
 					}
 				}
-				if (result == 0 || r < result)
-					result = r;
+				result = result.least(r);
 			}
 		}
 
-		return result + 1;
+		return result.next();
 	}
 
-	template <size_t N>
-	uint32_t calculate_crc32( const std::array<uint32_t, N> &data, uint32_t crc = 0 )
+	// the least result of parse_layout whose rating reaches the target weight
+	int threshold()
 	{
-		#define POLY 0xEDB88320
+		if (Sudoku::target == INT_MIN)
+			return INT_MAX;
+
+		int goal = Sudoku::target + static_cast<int>(Sudoku::len()) * 25;
+		if (Sudoku::scale_rating(INT_MAX) < goal)
+			return INT_MAX;
 
-		crc = ~crc;
-		for (uint32_t x: data)
+		int lo = 1, hi = INT_MAX;
+		while (lo < hi)
 		{
-			crc ^= x;
-			for (size_t i = 0; i < sizeof(x) * CHAR_BIT; i++)
-				crc = (crc & 1) ? (crc >> 1) ^ POLY : (crc >> 1);
+			int mid = lo + (hi - lo) / 2;
+			if (Sudoku::scale_rating(mid) < goal)
+				lo = mid + 1;
+			else
+				hi = mid;
 		}
-		crc = ~crc;
+		return lo;
+	}
 
-		return crc;
+	// full rating of a board truncated at the target
+	void complete()
+	{
+		int t = Sudoku::target;
+		Sudoku::target = INT_MIN;
+		Sudoku::calculate_rating();
+		Sudoku::target = t;
 	}
 
 	void calculate_rating( bool estimate = false )
 	{
-		Sudoku::rating = Sudoku::solvable(); if (Sudoku::rating != 0) return;
-		Sudoku::rating = Sudoku::correct();  if (Sudoku::rating != 0) return;
+		Sudoku::truncated = false;
+		Sudoku::upper = Sudoku::rating = Sudoku::solvable(); if (Sudoku::rating != 0) return;
+		Sudoku::upper = Sudoku::rating = Sudoku::correct();  if (Sudoku::rating != 0) return;
 
 		if (estimate || Sudoku::level == Difficulty::Extreme) return;
 
-		int msb = 0;
-		int result = Sudoku::parse_rating();
-		for (uint i = Sudoku::count(0); result > 0; Sudoku::rating += static_cast<int>(i--), result >>= 1)
-			msb = (result & 1) ? msb + 1 : 0;
-		Sudoku::rating += msb - 1;
+		if (Sudoku::grader == Grader::Logic)
+		{
+			Sudoku::upper = Sudoku::rating = Sudoku::grade().rating();
+			return;
+		}
+
+		if (Sudoku::budget.nodes != 0 || Sudoku::budget.ms != 0)
+		{
+			Meter m{Sudoku::budget};
+			Range r = Sudoku::parse_range(m);
+			Sudoku::truncated = m.out;
+			Sudoku::rating = Sudoku::scale_rating(r.zero || r.empty() ? 0 : r.lo);
+			Sudoku::upper  = r.empty() ? Sudoku::scale_rating(0) : r.hi == INT_MAX ? INT_MAX : Sudoku::scale_rating(r.hi);
+			return;
+		}
+
+		int cap = Sudoku::threshold();
+		if (cap < INT_MAX)
+		{
+			int lower = 0;
+			int result = Sudoku::parse_goal(cap, lower);
+			Sudoku::truncated = lower > 0 || result >= cap;
+			Sudoku::rating = Sudoku::scale_rating(lower > 0 ? lower : result);
+			Sudoku::upper  = lower > 0 || result < cap ? Sudoku::scale_rating(result) : INT_MAX;
+			return;
+		}
+
+		int result = Sudoku::jobs > 1 ? Sudoku::parse_layout(Sudoku::jobs) : Sudoku::parse_rating();
+		Sudoku::upper = Sudoku::rating = Sudoku::scale_rating(result);
 	//	Sudoku::rating = Sudoku::parse_rating();
 	}
 
@@ -992,32 +2589,51 @@ private:
 		Sudoku::again();
 	}
 
+	// the layout invariants behind the signature: sorted counts of digits, lengths and ranges of cells
+	std::array<uint32_t, 10 + 81 + 81> invariants()
+	{
+		std::array<uint32_t, 10 + 81 + 81> result{};
+		auto v = result.begin();
+		auto l = v + 10;
+		auto r = l + 81;
+
+		for (Cell &c: *this)
+		{
+			v[c.num]++;
+			l[c.pos] = static_cast<uint32_t>(c.len());
+			r[c.pos] = static_cast<uint32_t>(c.range());
+		}
+
+		std::sort(v, l);
+		std::sort(l, r);
+		std::sort(r, result.end());
+
+		return result;
+	}
+
 	void calculate_signature( bool estimate = false )
 	{
 		if (estimate)
 		{
 			Sudoku::signature = 0;
+			Sudoku::digest = 0;
 			return;
 		}
 
-		std::array<uint32_t, 10> v = { 0 };
-		std::array<uint32_t, 81> l;
-		std::array<uint32_t, 81> r;
+		auto data = Sudoku::invariants();
+		Sudoku::signature = Sudoku::castagnoli ? SudokuHash::crc32c(data.data(), sizeof(data)) : SudokuHash::crc32(data.data(), sizeof(data));
+		Sudoku::calculate_digest();
+	}
 
+	// the givens themselves, seeded with the signature: the isomorphs are told apart
+	void calculate_digest()
+	{
+		std::array<uint8_t, 81> num;
 		for (Cell &c: *this)
-		{
-			v[c.num]++;
-			l[c.pos] = static_cast<uint32_t>(c.len());
-			r[c.pos] = static_cast<uint32_t>(c.range());
-		}
+			num[c.pos] = static_cast<uint8_t>(c.immutable ? c.num : 0);
 
-		std::sort(std::begin(v), std::end(v));
-		std::sort(std::begin(l), std::end(l));
-		std::sort(std::begin(r), std::end(r));
-
-		Sudoku::signature = Sudoku::calculate_crc32(v);
-		Sudoku::signature = Sudoku::calculate_crc32(l, Sudoku::signature);
-		Sudoku::signature = Sudoku::calculate_crc32(r, Sudoku::signature);
+		auto data = SudokuHash::pack(num);
+		Sudoku::digest = SudokuHash::hash64(data.data(), data.size(), Sudoku::signature);
 	}
 
 	void specify_layout( bool estimate = false )
@@ -1165,7 +2781,13 @@ public:
 	}
 };
 
-const
+inline
+bool Sudoku::castagnoli = false;
+
+inline
+std::basic_string<TCHAR> Sudoku::pool_file = _T("sudoku.pool");
+
+inline const
 std::vector<std::basic_string<TCHAR>> Sudoku::extreme =
 {
 _T(".2.4.37.........32........4.4.2...7.8...5.........1...5.....9...3.9....7..1..86..|3:21:702:9c071975"),
@@ -1203,6 +2825,175 @@ _T(".26.........6....3.74.8.........3..2.8..4..1.6..5.........1.78.5....9.......
 _T(".98.1....2......6.............3.2.5..84.........6.4.......4.8.93..5.....8.....1.5|3:20:513:ebd7fdce"),
 };
 
-const
+inline const
 std::basic_string<TCHAR> Sudoku::html =
 _T("<!doctype html><html><head><title>sudoku</title><style>table{margin-left:auto;margin-right:auto;font-family:Tahoma,Verdana,sans-serif;font-weight:bold;}table,td{border:1px solid black;border-collapse:collapse;}td{width:80px;height:80px;font-size:64px;text-align:center;vertical-align:middle}#top-left{border-top-width:5px;border-left-width:5px;}#top{border-top-width:5px;}#top-right{border-top-width:5px;border-right-width:5px;}#left{border-left-width:5px;}#center{}#right{border-right-width:5px;}#bottom-left{border-bottom-width:5px;border-left-width:5px;}#bottom{border-bottom-width:5px;}#bottom-right{border-bottom-width:5px;border-right-width:5px;}</style></head><body><table><caption><h1>SUDOKU</h1></caption><tr><td id=top-left> </td><td id=top> </td><td id=top-right> </td><td id=top-left> </td><td id=top> </td><td id=top-right> </td><td id=top-left> </td><td id=top> </td><td id=top-right> </td></tr><tr><td id=left> </td><td id=center> </td><td id=right> </td><td id=left> </td><td id=center> </td><td id=right> </td><td id=left> </td><td id=center> </td><td id=right> </td></tr><tr><td id=bottom-left> </td><td id=bottom> </td><td id=bottom-right> </td><td id=bottom-left> </td><td id=bottom> </td><td id=bottom-right> </td><td id=bottom-left> </td><td id=bottom> </td><td id=bottom-right> </td></tr><tr><td id=top-left> </td><td id=top> </td><td id=top-right> </td><td id=top-left> </td><td id=top> </td><td id=top-right> </td><td id=top-left> </td><td id=top> </td><td id=top-right> </td></tr><tr><td id=left> </td><td id=center> </td><td id=right> </td><td id=left> </td><td id=center> </td><td id=right> </td><td id=left> </td><td id=center> </td><td id=right> </td></tr><tr><td id=bottom-left> </td><td id=bottom> </td><td id=bottom-right> </td><td id=bottom-left> </td><td id=bottom> </td><td id=bottom-right> </td><td id=bottom-left> </td><td id=bottom> </td><td id=bottom-right> </td></tr><tr><td id=top-left> </td><td id=top> </td><td id=top-right> </td><td id=top-left> </td><td id=top> </td><td id=top-right> </td><td id=top-left> </td><td id=top> </td><td id=top-right> </td></tr><tr><td id=left> </td><td id=center> </td><td id=right> </td><td id=left> </td><td id=center> </td><td id=right> </td><td id=left> </td><td id=center> </td><td id=right> </td></tr><tr><td id=bottom-left> </td><td id=bottom> </td><td id=bottom-right> </td><td id=bottom-left> </td><td id=bottom> </td><td id=bottom-right> </td><td id=bottom-left> </td><td id=bottom> </td><td id=bottom-right> </td></tr></table></body></html>");
+
+// set of boards already seen by a batch mode, keyed by the signature, the wide signature
+// or the canonical form (then every isomorph of a board is a duplicate)
+// open addressing with linear probing, 0 marks an empty slot (key 0 is kept apart)
+class SudokuIndex
+{
+	std::vector<uint64_t> tab;
+	size_t cnt;
+	bool   nil;
+	uint   shift;
+	Dedup  mode;
+
+	static
+	SudokuMinlex &minlex()
+	{
+		static thread_local SudokuMinlex minlex{};
+		return minlex;
+	}
+
+	size_t slot( uint64_t key ) const
+	{
+		return static_cast<size_t>((key * UINT64_C(0x9E3779B97F4A7C15)) >> SudokuIndex::shift);
+	}
+
+	size_t find( uint64_t key ) const
+	{
+		size_t msk = SudokuIndex::tab.size() - 1;
+		size_t pos = SudokuIndex::slot(key);
+		while (SudokuIndex::tab[pos] != 0 && SudokuIndex::tab[pos] != key)
+			pos = (pos + 1) & msk;
+		return pos;
+	}
+
+	void grow()
+	{
+		auto old = std::vector<uint64_t>(SudokuIndex::tab.size() * 2, 0);
+		std::swap(old, SudokuIndex::tab);
+		SudokuIndex::shift--;
+		for (uint64_t key: old)
+			if (key != 0)
+				SudokuIndex::tab[SudokuIndex::find(key)] = key;
+	}
+
+	// signature recorded at the end of the line: "board|level:length:rating:signature"
+	static
+	bool parse( const std::basic_string<TCHAR> &line, uint32_t &sig )
+	{
+		auto pos = line.rfind(_T(':'));
+		if (line.find(_T('|')) != 81 || pos == line.npos || pos + 1 == line.size())
+			return false;
+
+		sig = 0;
+		while (pos + 2 < line.size() && line[pos + 1] == _T(' ')) // the signature is written with setw(8)
+			pos++;
+		for (auto i = pos + 1; i < line.size(); i++)
+		{
+			TCHAR c = line[i];
+			uint  x = c >= _T('0') && c <= _T('9') ? static_cast<uint>(c - _T('0'))      :
+			          c >= _T('a') && c <= _T('f') ? static_cast<uint>(c - _T('a')) + 10 :
+			          c >= _T('A') && c <= _T('F') ? static_cast<uint>(c - _T('A')) + 10 : 16;
+			if (x > 15 || i - pos > 8)
+				return false;
+			sig = (sig << 4) | x;
+		}
+
+		return true;
+	}
+
+public:
+
+	SudokuIndex( Dedup _m = Dedup::Signature ): tab(1024, 0), cnt{0}, nil{false}, shift{64 - 10}, mode{_m} {}
+
+	size_t size() const { return SudokuIndex::cnt; }
+
+	// the givens only: entered digits do not count
+	uint64_t key( Sudoku &sudoku ) const
+	{
+		if (SudokuIndex::mode == Dedup::Signature)
+			return sudoku.signature;
+		if (SudokuIndex::mode == Dedup::Digest)
+			return sudoku.digest;
+
+		SudokuMinlex::Grid g;
+		for (SudokuCell &c: sudoku)
+			g[c.pos] = static_cast<uint8_t>(c.immutable ? c.num : 0);
+		return SudokuMinlex::key(SudokuIndex::minlex().canon(g));
+	}
+
+	bool contains( uint64_t key ) const
+	{
+		return key == 0 ? SudokuIndex::nil : SudokuIndex::tab[SudokuIndex::find(key)] != 0;
+	}
+
+	bool contains( Sudoku &sudoku ) const
+	{
+		return SudokuIndex::contains(SudokuIndex::key(sudoku));
+	}
+
+	// false if the key was already there
+	bool insert( uint64_t key )
+	{
+		if (key == 0)
+		{
+			if (SudokuIndex::nil)
+				return false;
+			SudokuIndex::nil = true;
+			SudokuIndex::cnt++;
+			return true;
+		}
+
+		size_t pos = SudokuIndex::find(key);
+		if (SudokuIndex::tab[pos] != 0)
+			return false;
+
+		SudokuIndex::tab[pos] = key;
+		if (++SudokuIndex::cnt * 2 > SudokuIndex::tab.size())
+			SudokuIndex::grow();
+		return true;
+	}
+
+	bool insert( Sudoku &sudoku )
+	{
+		return SudokuIndex::insert(SudokuIndex::key(sudoku));
+	}
+
+	// preload the keys of the boards stored in the file; only the lines
+	// with no recorded signature are rated
+	void load( const TCHAR *filename )
+	{
+		auto file = std::basic_ifstream<TCHAR>(filename);
+		if (!file.is_open())
+			return;
+
+		auto sudoku = Sudoku(Difficulty::Medium);
+		std::basic_string<TCHAR> line;
+		while (std::getline(file, line))
+		{
+			uint32_t sig;
+			if (line.size() > 0 && line.back() == _T('\r'))
+				line.pop_back();
+			if (line.size() == 0)
+				continue;
+			SudokuMinlex::Grid g;
+			for (uint i = 0; i < 81; i++)
+				g[i] = static_cast<uint8_t>(i < line.size() && line[i] >= _T('1') && line[i] <= _T('9') ? line[i] - _T('0') : 0);
+			if (SudokuIndex::mode == Dedup::Canonical)
+			{
+				SudokuIndex::insert(SudokuMinlex::key(SudokuIndex::minlex().canon(g)));
+				continue;
+			}
+			if (!SudokuIndex::parse(line, sig))
+			{
+				sudoku.init(line.substr(0, 81));
+				SudokuIndex::insert(sudoku);
+				continue;
+			}
+			if (SudokuIndex::mode == Dedup::Digest)
+			{
+				// the same key as Sudoku::calculate_digest, from the recorded signature
+				auto data = SudokuHash::pack(g);
+				SudokuIndex::insert(SudokuHash::hash64(data.data(), data.size(), sig));
+				continue;
+			}
+			SudokuIndex::insert(sig);
+		}
+
+		file.close();
+	}
+};
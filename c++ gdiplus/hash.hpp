@@ -0,0 +1,231 @@
+/******************************************************************************
+
+   @file    hash.hpp 
+   @author  Rajmund Szymanski
+   @date    29.12.2020
+   @brief   checksums and hashes of boards
+
+*******************************************************************************
+
+   Copyright (c) 2018 - 2020 Rajmund Szymanski. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+
+******************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <nmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SUDOKU_SSE42
+#else
+#define SUDOKU_SSE42 __attribute__((target("sse4.2")))
+#endif
+#define SUDOKU_CRC32C_HW
+#endif
+
+// crc32:   CRC-32 (IEEE), table driven; gives the same values as the former
+//          bit-at-a-time signature, so the signatures in existing board files stay valid
+// crc32c:  CRC-32C (Castagnoli), SSE4.2 instruction if the CPU has it (checked at run time),
+//          otherwise table driven with the same result
+// hash64:  MurmurHash3 (x64, 128-bit) over the whole input, the first 64 bits of the result
+
+class SudokuHash
+{
+	using uint = unsigned int;
+	using Table = std::array<uint32_t, 256>;
+
+	static constexpr
+	Table make( uint32_t poly )
+	{
+		Table result{};
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			uint32_t crc = i;
+			for (uint k = 0; k < 8; k++)
+				crc = (crc & 1) ? (crc >> 1) ^ poly : (crc >> 1);
+			result[i] = crc;
+		}
+		return result;
+	}
+
+	static const Table crc32_table;
+	static const Table crc32c_table;
+	static const bool  hardware;
+
+	static
+	bool detect()
+	{
+#if defined(SUDOKU_CRC32C_HW) && defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		return (info[2] & (1 << 20)) != 0;
+#elif defined(SUDOKU_CRC32C_HW)
+		return __builtin_cpu_supports("sse4.2");
+#else
+		return false;
+#endif
+	}
+
+	static
+	uint32_t update( const Table &tab, const uint8_t *data, size_t size, uint32_t crc )
+	{
+		while (size--)
+			crc = tab[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+		return crc;
+	}
+
+#if defined(SUDOKU_CRC32C_HW)
+	static SUDOKU_SSE42
+	uint32_t crc32c_hw( const uint8_t *data, size_t size, uint32_t crc )
+	{
+		uint64_t c = crc;
+		for (; size >= 8; data += 8, size -= 8)
+		{
+			uint64_t w;
+			std::memcpy(&w, data, sizeof(w));
+			c = _mm_crc32_u64(c, w);
+		}
+		crc = static_cast<uint32_t>(c);
+		for (; size > 0; data++, size--)
+			crc = _mm_crc32_u8(crc, *data);
+		return crc;
+	}
+#endif
+
+	static
+	uint64_t load64( const uint8_t *data )
+	{
+		uint64_t w;
+		std::memcpy(&w, data, sizeof(w));
+		return w;
+	}
+
+	static
+	uint64_t fmix64( uint64_t k )
+	{
+		k ^= k >> 33;
+		k *= UINT64_C(0xFF51AFD7ED558CCD);
+		k ^= k >> 33;
+		k *= UINT64_C(0xC4CEB9FE1A85EC53);
+		k ^= k >> 33;
+		return k;
+	}
+
+	static
+	uint64_t rotl64( uint64_t x, int r )
+	{
+		return (x << r) | (x >> (64 - r));
+	}
+
+public:
+
+	using Packed = std::array<uint8_t, 41>;
+
+	static bool accelerated() { return SudokuHash::hardware; }
+
+	static
+	uint32_t crc32( const void *data, size_t size, uint32_t crc = 0 )
+	{
+		return ~SudokuHash::update(SudokuHash::crc32_table, static_cast<const uint8_t *>(data), size, ~crc);
+	}
+
+	static
+	uint32_t crc32c( const void *data, size_t size, uint32_t crc = 0 )
+	{
+#if defined(SUDOKU_CRC32C_HW)
+		if (SudokuHash::hardware)
+			return ~SudokuHash::crc32c_hw(static_cast<const uint8_t *>(data), size, ~crc);
+#endif
+		return ~SudokuHash::update(SudokuHash::crc32c_table, static_cast<const uint8_t *>(data), size, ~crc);
+	}
+
+	static
+	uint64_t hash64( const void *data, size_t size, uint64_t seed = 0 )
+	{
+		constexpr uint64_t c1 = UINT64_C(0x87C37B91114253D5);
+		constexpr uint64_t c2 = UINT64_C(0x4CF5AD432745937F);
+
+		auto     p  = static_cast<const uint8_t *>(data);
+		size_t   n  = size / 16;
+		uint64_t h1 = seed;
+		uint64_t h2 = seed;
+
+		for (size_t i = 0; i < n; i++, p += 16)
+		{
+			uint64_t k1 = SudokuHash::load64(p);
+			uint64_t k2 = SudokuHash::load64(p + 8);
+
+			k1 *= c1; k1 = SudokuHash::rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+			h1 = SudokuHash::rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52DCE729;
+			k2 *= c2; k2 = SudokuHash::rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+			h2 = SudokuHash::rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495AB5;
+		}
+
+		uint64_t k1 = 0;
+		uint64_t k2 = 0;
+		size_t   t  = size & 15;
+		for (size_t i = t; i > 8; i--)
+			k2 ^= static_cast<uint64_t>(p[i - 1]) << ((i - 9) * 8);
+		if (t > 8)
+		{
+			k2 *= c2; k2 = SudokuHash::rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+		}
+		for (size_t i = t < 8 ? t : 8; i > 0; i--)
+			k1 ^= static_cast<uint64_t>(p[i - 1]) << ((i - 1) * 8);
+		if (t > 0)
+		{
+			k1 *= c1; k1 = SudokuHash::rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+		}
+
+		h1 ^= size; h2 ^= size;
+		h1 += h2; h2 += h1;
+		h1 = SudokuHash::fmix64(h1);
+		h2 = SudokuHash::fmix64(h2);
+		h1 += h2;
+
+		return h1;
+	}
+
+	// 81 digits, two per byte
+	template<class T>
+	static
+	Packed pack( const T &tab )
+	{
+		Packed result{};
+		for (uint p = 0; p < 81; p++)
+			result[p / 2] = static_cast<uint8_t>(result[p / 2] | (tab[p] & 0x0F) << (p % 2 * 4));
+		return result;
+	}
+};
+
+inline constexpr
+SudokuHash::Table SudokuHash::crc32_table = SudokuHash::make(0xEDB88320);
+
+inline constexpr
+SudokuHash::Table SudokuHash::crc32c_table = SudokuHash::make(0x82F63B78);
+
+inline const
+bool SudokuHash::hardware = SudokuHash::detect();
@@ -0,0 +1,232 @@
+/******************************************************************************
+
+   @file    pool.hpp
+   @author  Rajmund Szymanski
+   @date    29.12.2020
+   @brief   memory-mapped pool of boards indexed by level and rating
+
+*******************************************************************************
+
+   Copyright (c) 2018 - 2020 Rajmund Szymanski. All rights reserved.
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+
+******************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <cstdint>
+#include <cstring>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <tchar.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// The pool file is a header followed by fixed-width records sorted by level and
+// then by rating; the header holds the index of the first record of every level.
+// The file is mapped, not read, so opening it does not depend on its size, a draw
+// from a level is one index and a draw from a range of ratings is a binary search.
+// All the numbers are little-endian.
+
+class SudokuPool
+{
+	using uint = unsigned int;
+
+public:
+
+	static constexpr uint levels = 5; // Easy .. Extreme
+
+	struct Record
+	{
+		uint8_t  cells[41]; // the givens, two cells per byte (the low nibble first)
+		uint8_t  level;
+		uint16_t len;       // number of the givens
+		int32_t  rating;
+
+		uint get( uint p ) const { return (Record::cells[p / 2] >> (p % 2 * 4)) & 0xF; }
+		void set( uint p, uint n ) { Record::cells[p / 2] = static_cast<uint8_t>(Record::cells[p / 2] | n << (p % 2 * 4)); }
+
+		// the file is not trusted: digits, level and number of the givens are checked before the record is used
+		bool valid() const
+		{
+			uint n = 0;
+			for (uint p = 0; p < 81; p++)
+			{
+				uint v = Record::get(p);
+				if (v > 9)
+					return false;
+				n += v != 0;
+			}
+			return Record::level < levels && Record::len == n && (Record::cells[40] >> 4) == 0;
+		}
+	};
+
+	static_assert(sizeof(Record) == 48);
+
+private:
+
+	struct Header
+	{
+		char     magic[8];
+		uint64_t first[levels + 1]; // first record of every level, the last one: number of records
+	};
+
+	static_assert(sizeof(Header) == 56);
+
+	static constexpr char magic[8] = { 'S', 'U', 'D', 'O', 'K', 'U', 'P', '1' };
+
+	const Header *head{nullptr};
+	const Record *data{nullptr};
+	size_t        bytes{0};
+#if defined(_WIN32)
+	HANDLE        file{INVALID_HANDLE_VALUE};
+	HANDLE        view{nullptr};
+#endif
+
+public:
+
+	SudokuPool() = default;
+	SudokuPool( const SudokuPool & ) = delete;
+	SudokuPool &operator=( const SudokuPool & ) = delete;
+	~SudokuPool() { SudokuPool::close(); }
+
+	template<class T>
+	explicit SudokuPool( const T *filename ) { SudokuPool::open(filename); }
+
+	template<class T>
+	bool open( const T *filename )
+	{
+		SudokuPool::close();
+
+		const void *addr = nullptr;
+#if defined(_WIN32)
+		SudokuPool::file = CreateFile(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (SudokuPool::file == INVALID_HANDLE_VALUE)
+			return false;
+		LARGE_INTEGER size;
+		if (GetFileSizeEx(SudokuPool::file, &size) && size.QuadPart >= static_cast<LONGLONG>(sizeof(Header)))
+			SudokuPool::view = CreateFileMapping(SudokuPool::file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (SudokuPool::view != nullptr)
+			addr = MapViewOfFile(SudokuPool::view, FILE_MAP_READ, 0, 0, 0);
+		SudokuPool::bytes = addr != nullptr ? static_cast<size_t>(size.QuadPart) : 0;
+#else
+		int fd = ::open(filename, O_RDONLY);
+		if (fd < 0)
+			return false;
+		struct stat st;
+		if (fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(Header)))
+		{
+			void *m = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+			if (m != MAP_FAILED)
+			{
+				addr = m;
+				SudokuPool::bytes = static_cast<size_t>(st.st_size);
+			}
+		}
+		::close(fd);
+#endif
+		if (addr == nullptr)
+		{
+			SudokuPool::close();
+			return false;
+		}
+
+		SudokuPool::head = static_cast<const Header *>(addr);
+		SudokuPool::data = reinterpret_cast<const Record *>(SudokuPool::head + 1);
+
+		// the records must fit in the file and the index must be in order
+		bool valid = std::memcmp(SudokuPool::head->magic, magic, sizeof(magic)) == 0 &&
+		             SudokuPool::head->first[levels] <= (SudokuPool::bytes - sizeof(Header)) / sizeof(Record);
+		for (uint l = 0; valid && l < levels; l++)
+			valid = SudokuPool::head->first[l] <= SudokuPool::head->first[l + 1];
+		if (!valid)
+			SudokuPool::close();
+
+		return valid;
+	}
+
+	void close()
+	{
+#if defined(_WIN32)
+		if (SudokuPool::head != nullptr) UnmapViewOfFile(SudokuPool::head);
+		if (SudokuPool::view != nullptr) CloseHandle(SudokuPool::view);
+		if (SudokuPool::file != INVALID_HANDLE_VALUE) CloseHandle(SudokuPool::file);
+		SudokuPool::view = nullptr;
+		SudokuPool::file = INVALID_HANDLE_VALUE;
+#else
+		if (SudokuPool::head != nullptr)
+			munmap(const_cast<Header *>(SudokuPool::head), SudokuPool::bytes);
+#endif
+		SudokuPool::head = nullptr;
+		SudokuPool::data = nullptr;
+		SudokuPool::bytes = 0;
+	}
+
+	bool is_open() const { return SudokuPool::head != nullptr; }
+
+	size_t size() const { return SudokuPool::head != nullptr ? SudokuPool::head->first[levels] : 0; }
+
+	// records of the level, sorted by rating
+	const Record *begin( uint level ) const { return level < levels && SudokuPool::head != nullptr ? SudokuPool::data + SudokuPool::head->first[level] : nullptr; }
+	const Record *end  ( uint level ) const { return level < levels && SudokuPool::head != nullptr ? SudokuPool::data + SudokuPool::head->first[level + 1] : nullptr; }
+
+	size_t size( uint level ) const { return static_cast<size_t>(SudokuPool::end(level) - SudokuPool::begin(level)); }
+
+	// records of the level rated from lo to hi
+	std::pair<const Record *, const Record *> range( uint level, int lo, int hi ) const
+	{
+		auto by_rating = []( const Record &r, int v ){ return r.rating < v; };
+		auto first = std::lower_bound(SudokuPool::begin(level), SudokuPool::end(level), lo, by_rating);
+		auto last  = std::upper_bound(first, SudokuPool::end(level), hi, []( int v, const Record &r ){ return v < r.rating; });
+		return { first, last };
+	}
+
+	// the records are sorted and written with the index
+	template<class T>
+	static bool write( const T *filename, std::vector<Record> &lst )
+	{
+		std::stable_sort(lst.begin(), lst.end(), []( const Record &a, const Record &b ){ return a.level < b.level || (a.level == b.level && a.rating < b.rating); });
+
+		Header h{};
+		std::memcpy(h.magic, magic, sizeof(magic));
+		for (uint l = 0; l <= levels; l++)
+			h.first[l] = static_cast<uint64_t>(std::lower_bound(lst.begin(), lst.end(), l, []( const Record &r, uint v ){ return r.level < v; }) - lst.begin());
+
+		auto file = std::ofstream(filename, std::ios::out | std::ios::binary);
+		if (!file.is_open())
+			return false;
+
+		file.write(reinterpret_cast<const char *>(&h), sizeof(h));
+		file.write(reinterpret_cast<const char *>(lst.data()), static_cast<std::streamsize>(lst.size() * sizeof(Record)));
+		return file.good();
+	}
+};
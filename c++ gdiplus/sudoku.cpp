@@ -665,6 +665,8 @@ void GameFooter::update( Graphics &gr, const TCHAR *info )
 
 Game::Game(): hdr{}, tab{*this}, mnu{}, ftr{}, number{0}, tracking{false}, timer_f{true}, light_f{false}, help{Assistance::None}
 {
+	Sudoku::jobs = std::max(std::thread::hardware_concurrency(), 1U);
+
 	Sudoku::generate();
 
 	Game::mnu[0].setIndex(Sudoku::level);